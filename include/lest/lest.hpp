@@ -10,12 +10,19 @@
 #define LEST_LEST_HPP_INCLUDED
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <exception>
+#include <fstream>
 #include <functional>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <map>
+#include <memory>
+#include <numeric>
 #include <random>
 #include <sstream>
 #include <stdexcept>
@@ -24,12 +31,17 @@
 #include <tuple>
 #include <typeinfo>
 #include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include <cctype>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 
 #define lest_MAJOR  1
 #define lest_MINOR  37
@@ -45,14 +57,54 @@
 # define lest_FEATURE_COLOURISE  0
 #endif
 
+#ifndef  lest_FEATURE_HEAP_PROFILE
+# define lest_FEATURE_HEAP_PROFILE  0
+#endif
+
+#ifndef  lest_FEATURE_ISOLATE
+# define lest_FEATURE_ISOLATE  0
+#endif
+
+#ifndef  lest_FEATURE_JOBS
+# define lest_FEATURE_JOBS  0
+#endif
+
+#ifndef  lest_FEATURE_LINKER_REGISTER
+# define lest_FEATURE_LINKER_REGISTER  0
+#endif
+
 #ifndef  lest_FEATURE_LITERAL_SUFFIX
 # define lest_FEATURE_LITERAL_SUFFIX  0
 #endif
 
+#ifndef  lest_FEATURE_MANIFEST
+# define lest_FEATURE_MANIFEST  0
+#endif
+
+#ifndef  lest_FEATURE_MAX_PRINT
+# define lest_FEATURE_MAX_PRINT  1000
+#endif
+
+#ifndef  lest_FEATURE_MAX_PRINT_BYTES
+# define lest_FEATURE_MAX_PRINT_BYTES  65536
+#endif
+
+#ifndef  lest_FEATURE_MAX_PRINT_DEPTH
+# define lest_FEATURE_MAX_PRINT_DEPTH  16
+#endif
+
+#ifndef  lest_FEATURE_PERF_COUNTERS
+# define lest_FEATURE_PERF_COUNTERS  0
+#endif
+
 #ifndef  lest_FEATURE_REGEX_SEARCH
 # define lest_FEATURE_REGEX_SEARCH  0
 #endif
 
+#ifndef  lest_FEATURE_SERVE
+# define lest_FEATURE_SERVE  0
+#endif
+
 #ifndef  lest_FEATURE_TIME_PRECISION
 # define lest_FEATURE_TIME_PRECISION  0
 #endif
@@ -71,10 +123,83 @@
 # define  lest__cpp_rtti  0
 #endif
 
+// Registry in a linker section needs ELF __start_ and __stop_ symbols:
+
+#if lest_FEATURE_AUTO_REGISTER && lest_FEATURE_LINKER_REGISTER && defined(__GNUC__) && defined(__ELF__)
+# define  lest__linker_register  1
+#else
+# define  lest__linker_register  0
+#endif
+
+// Manifest of auto-registered tests in a linker section, idem:
+
+#if lest_FEATURE_AUTO_REGISTER && lest_FEATURE_MANIFEST && defined(__GNUC__) && defined(__ELF__)
+# define  lest__manifest  1
+#else
+# define  lest__manifest  0
+#endif
+
+// Event counters via perf_event_open() are specific to Linux:
+
+#if lest_FEATURE_PERF_COUNTERS && defined(__linux__)
+# define  lest__perf_counters  1
+#else
+# define  lest__perf_counters  0
+#endif
+
+// Heap profiling needs backtrace() and dladdr() of glibc or macOS:
+
+#if lest_FEATURE_HEAP_PROFILE && ( defined(__GLIBC__) || defined(__APPLE__) )
+# define  lest__heap_profile  1
+#else
+# define  lest__heap_profile  0
+#endif
+
 #if lest_FEATURE_REGEX_SEARCH
 # include <regex>
 #endif
 
+#if lest_FEATURE_JOBS
+# include <condition_variable>
+# include <mutex>
+# include <thread>
+#endif
+
+#if lest_FEATURE_ISOLATE || lest_FEATURE_SERVE
+# include <cerrno>
+# include <csignal>
+# include <cstdio>
+# include <sys/types.h>
+# include <unistd.h>
+#endif
+
+#if lest_FEATURE_ISOLATE
+# include <poll.h>
+# include <sys/mman.h>
+# include <sys/resource.h>
+# include <sys/wait.h>
+#endif
+
+#if lest_FEATURE_SERVE
+# include <sys/socket.h>
+# include <sys/un.h>
+#endif
+
+#if lest__heap_profile
+# include <cxxabi.h>
+# include <dlfcn.h>
+# include <execinfo.h>
+# include <mutex>
+#endif
+
+#if lest__perf_counters
+# include <cerrno>
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
 // Stringify:
 
 #define lest_STRINGIFY(  x )  lest_STRINGIFY_( x )
@@ -144,6 +269,20 @@
 # define __has_cpp_attribute(name)  0
 #endif
 
+// Use std::to_chars() to format floating point values, if available:
+
+#if lest_CPP17_OR_GREATER && defined( __has_include )
+# if __has_include( <charconv> )
+#  include <charconv>
+# endif
+#endif
+
+#if defined( __cpp_lib_to_chars ) && __cpp_lib_to_chars >= 201611L
+# define lest_HAVE_TO_CHARS  1
+#else
+# define lest_HAVE_TO_CHARS  0
+#endif
+
 // Indicate argument as possibly unused, if possible:
 
 #if __has_cpp_attribute(maybe_unused) && lest_CPP17_OR_GREATER
@@ -154,6 +293,23 @@
 # define lest_MAYBE_UNUSED(ARG)  ARG
 #endif
 
+// Keep a function out of line and whole, and obtain the address it returns
+// to, if possible:
+
+#if defined (__clang__)
+# define lest_NOINLINE          __attribute__(( noinline ))
+# define lest_RETURN_ADDRESS()  __builtin_return_address( 0 )
+#elif defined (__GNUC__)
+# define lest_NOINLINE          __attribute__(( noinline, noclone ))
+# define lest_RETURN_ADDRESS()  __builtin_return_address( 0 )
+#elif defined (_MSC_VER)
+# define lest_NOINLINE          __declspec( noinline )
+# define lest_RETURN_ADDRESS()  nullptr
+#else
+# define lest_NOINLINE          /*empty*/
+# define lest_RETURN_ADDRESS()  nullptr
+#endif
+
 #if ! defined( lest_NO_SHORT_MACRO_NAMES ) && ! defined( lest_NO_SHORT_ASSERTION_NAMES )
 # define MODULE            lest_MODULE
 
@@ -161,16 +317,33 @@
 #  define CASE             lest_CASE
 #  define CASE_ON          lest_CASE_ON
 #  define SCENARIO         lest_SCENARIO
+#  define BENCHMARK        lest_BENCHMARK
 # endif
 
 # define SETUP             lest_SETUP
 # define SECTION           lest_SECTION
+# define INFO              lest_INFO
+# define CAPTURE           lest_CAPTURE
 
 # define EXPECT            lest_EXPECT
 # define EXPECT_NOT        lest_EXPECT_NOT
 # define EXPECT_NO_THROW   lest_EXPECT_NO_THROW
 # define EXPECT_THROWS     lest_EXPECT_THROWS
 # define EXPECT_THROWS_AS  lest_EXPECT_THROWS_AS
+# define EXPECT_RANGE_EQ   lest_EXPECT_RANGE_EQ
+# define EXPECT_ALL        lest_EXPECT_ALL
+# define EXPECT_RANGE_APPROX  lest_EXPECT_RANGE_APPROX
+# define EXPECT_INSTRUCTIONS_BELOW  lest_EXPECT_INSTRUCTIONS_BELOW
+# define EXPECT_COMPLEXITY  lest_EXPECT_COMPLEXITY
+# define EXPECT_FASTER      lest_EXPECT_FASTER
+# define EXPECT_MAX_ALLOCS  lest_EXPECT_MAX_ALLOCS
+# define EXPECT_NO_ALLOC    lest_EXPECT_NO_ALLOC
+
+# define CHECK             lest_CHECK
+# define CHECK_NOT         lest_CHECK_NOT
+# define CHECK_NO_THROW    lest_CHECK_NO_THROW
+# define CHECK_THROWS      lest_CHECK_THROWS
+# define CHECK_THROWS_AS   lest_CHECK_THROWS_AS
 
 # define GIVEN             lest_GIVEN
 # define WHEN              lest_WHEN
@@ -184,17 +357,43 @@
 #else
 #define lest_SCENARIO( sketch  )  lest_CASE(    lest::text("Scenario: ") + sketch  )
 #endif
+#if lest_FEATURE_AUTO_REGISTER
+#define lest_BENCHMARK( specification, proposition )  lest_CASE( specification, lest::text( proposition ) + " [.benchmark]" )
+#else
+#define lest_BENCHMARK( proposition )  lest_CASE( lest::text( proposition ) + " [.benchmark]" )
+#endif
 #define lest_GIVEN(    context )  lest_SETUP(   lest::text("   Given: ") + context )
 #define lest_WHEN(     story   )  lest_SECTION( lest::text("    When: ") + story   )
 #define lest_THEN(     story   )  lest_SECTION( lest::text("    Then: ") + story   )
 #define lest_AND_WHEN( story   )  lest_SECTION( lest::text("And then: ") + story   )
 #define lest_AND_THEN( story   )  lest_SECTION( lest::text("And then: ") + story   )
 
-#if lest_FEATURE_AUTO_REGISTER
+// Manifest entry "file<tab>line<tab>proposition" for each auto-registered test:
+
+#if lest__manifest
+# define lest_MANIFEST_ENTRY( proposition ) \
+    __attribute__(( used, section( "lest_manifest" ) )) \
+    static const char lest_MANIFEST[] = __FILE__ "\t" lest_STRINGIFY( __LINE__ ) "\t" #proposition;
+#else
+# define lest_MANIFEST_ENTRY( proposition )
+#endif
+
+#if lest__linker_register
+
+#define lest_CASE( specification, proposition ) \
+    lest_MANIFEST_ENTRY( proposition ) \
+    static void lest_FUNCTION( lest::env & ); \
+    static lest::text lest_NAME() { return proposition; } \
+    __attribute__(( used, section( "lest_registry" ) )) \
+    static lest::registration const lest_REGISTRAR = { lest_NAME, __FILE__, __LINE__, lest_FUNCTION }; \
+    static void lest_FUNCTION( lest_MAYBE_UNUSED( lest::env & lest_env ) )
+
+#elif lest_FEATURE_AUTO_REGISTER
 
 #define lest_CASE( specification, proposition ) \
+    lest_MANIFEST_ENTRY( proposition ) \
     static void lest_FUNCTION( lest::env & ); \
-    static lest::add_test lest_REGISTRAR( specification, lest::test( proposition, lest_FUNCTION ) ); \
+    static lest::add_test lest_REGISTRAR( specification, lest::test( proposition, lest_FUNCTION, __FILE__, __LINE__ ) ); \
     static void lest_FUNCTION( lest_MAYBE_UNUSED( lest::env & lest_env ) )
 
 
@@ -227,18 +426,21 @@
             for ( lest::ctx lest__ctx_section( lest_env, proposition ); lest__ctx_section; ) \
     lest_RESTORE_WARNINGS
 
+#define lest_INFO( ... ) \
+    auto && lest_UNIQUE( lest__info ) = lest::make_info( lest_env, [&]() { return lest::info_text( __VA_ARGS__ ); } )
+
+#define lest_CAPTURE( ... ) \
+    auto && lest_UNIQUE( lest__info ) = lest::make_info( lest_env, [&]() { return lest::capture_text( #__VA_ARGS__, __VA_ARGS__ ); } )
+
 #define lest_EXPECT( expr ) \
     do { \
         try \
         { \
-            if ( lest::result score = lest_DECOMPOSE( expr ) ) \
-                throw lest::failure{ lest_LOCATION, #expr, score.decomposition }; \
-            else if ( lest_env.pass() ) \
-                lest::report( lest_env.os, lest::passing{ lest_LOCATION, #expr, score.decomposition, lest_env.zen() }, lest_env.context() ); \
+            lest::expect( lest_env, lest_DECOMPOSE( expr ), __FILE__, __LINE__, #expr ); \
         } \
         catch(...) \
         { \
-            lest::inform( lest_LOCATION, #expr ); \
+            lest::inform( lest_env, lest_LOCATION, #expr ); \
         } \
     } while ( lest::is_false() )
 
@@ -246,17 +448,11 @@
     do { \
         try \
         { \
-            if ( lest::result score = lest_DECOMPOSE( expr ) ) \
-            { \
-                if ( lest_env.pass() ) \
-                    lest::report( lest_env.os, lest::passing{ lest_LOCATION, lest::not_expr( #expr ), lest::not_expr( score.decomposition ), lest_env.zen() }, lest_env.context() ); \
-            } \
-            else \
-                throw lest::failure{ lest_LOCATION, lest::not_expr( #expr ), lest::not_expr( score.decomposition ) }; \
+            lest::expect_not( lest_env, lest_DECOMPOSE( expr ), __FILE__, __LINE__, #expr ); \
         } \
         catch(...) \
         { \
-            lest::inform( lest_LOCATION, lest::not_expr( #expr ) ); \
+            lest::inform( lest_env, lest_LOCATION, lest::not_expr( #expr ) ); \
         } \
     } while ( lest::is_false() )
 
@@ -271,7 +467,7 @@
         } \
         catch (...) \
         { \
-            lest::inform( lest_LOCATION, #expr ); \
+            lest::inform( lest_env, lest_LOCATION, #expr ); \
         } \
         if ( lest_env.pass() ) \
             lest::report( lest_env.os, lest::got_none( lest_LOCATION, #expr ), lest_env.context() ); \
@@ -288,10 +484,12 @@
         } \
         catch (...) \
         { \
+            lest_env.settle(); \
             if ( lest_env.pass() ) \
                 lest::report( lest_env.os, lest::got{ lest_LOCATION, #expr }, lest_env.context() ); \
             break; \
         } \
+        lest_env.settle(); \
         throw lest::expected{ lest_LOCATION, #expr }; \
     } \
     while ( lest::is_false() )
@@ -307,15 +505,195 @@
         }  \
         catch ( excpt & ) \
         { \
+            lest_env.settle(); \
             if ( lest_env.pass() ) \
+            { \
+                lest::arena_scope lest_arena; \
                 lest::report( lest_env.os, lest::got{ lest_LOCATION, #expr, lest::of_type( #excpt ) }, lest_env.context() ); \
+            } \
             break; \
         } \
         catch (...) {} \
+        lest_env.settle(); \
         throw lest::expected{ lest_LOCATION, #expr, lest::of_type( #excpt ) }; \
     } \
     while ( lest::is_false() )
 
+#define lest_EXPECT_INSTRUCTIONS_BELOW( n, expr ) \
+    do { \
+        try \
+        { \
+            lest::expect_instructions_below( lest_env, n, [&]() { lest_SUPPRESS_WUNUSED expr; lest_RESTORE_WARNINGS }, __FILE__, __LINE__, #expr, #n ); \
+        } \
+        catch(...) \
+        { \
+            lest::inform( lest_env, lest_LOCATION, #expr ); \
+        } \
+    } while ( lest::is_false() )
+
+#define lest_EXPECT_MAX_ALLOCS( n, expr ) \
+    do { \
+        try \
+        { \
+            lest::expect_max_allocs( lest_env, n, [&]() { lest_SUPPRESS_WUNUSED expr; lest_RESTORE_WARNINGS }, __FILE__, __LINE__, #expr, #n ); \
+        } \
+        catch(...) \
+        { \
+            lest::inform( lest_env, lest_LOCATION, #expr ); \
+        } \
+    } while ( lest::is_false() )
+
+#define lest_EXPECT_NO_ALLOC( expr ) \
+    lest_EXPECT_MAX_ALLOCS( 0, expr )
+
+#define lest_EXPECT_FASTER( baseline, candidate, min_speedup ) \
+    do { \
+        try \
+        { \
+            lest::expect_faster( lest_env, baseline, candidate, min_speedup, __FILE__, __LINE__, #baseline, #candidate, #min_speedup ); \
+        } \
+        catch(...) \
+        { \
+            lest::inform( lest_env, lest_LOCATION, "speedup( " #baseline ", " #candidate " )" ); \
+        } \
+    } while ( lest::is_false() )
+
+#define lest_EXPECT_COMPLEXITY( body, sizes, expected ) \
+    do { \
+        try \
+        { \
+            lest::expect_complexity( lest_env, body, sizes, []() -> lest::complexity { using namespace lest::complexities; return expected; }(), __FILE__, __LINE__, #body, #expected ); \
+        } \
+        catch(...) \
+        { \
+            lest::inform( lest_env, lest_LOCATION, "complexity( " #body " )" ); \
+        } \
+    } while ( lest::is_false() )
+
+// Soft assertions: report and count a failure and let the test continue:
+
+#define lest_CHECK( expr ) \
+    do { \
+        try \
+        { \
+            lest::check( lest_env, lest_DECOMPOSE( expr ), __FILE__, __LINE__, #expr ); \
+        } \
+        catch(...) \
+        { \
+            lest::record_unexpected( lest_env, lest_LOCATION, #expr ); \
+        } \
+    } while ( lest::is_false() )
+
+#define lest_CHECK_NOT( expr ) \
+    do { \
+        try \
+        { \
+            lest::check_not( lest_env, lest_DECOMPOSE( expr ), __FILE__, __LINE__, #expr ); \
+        } \
+        catch(...) \
+        { \
+            lest::record_unexpected( lest_env, lest_LOCATION, lest::not_expr( #expr ) ); \
+        } \
+    } while ( lest::is_false() )
+
+#define lest_CHECK_NO_THROW( expr ) \
+    do \
+    { \
+        try \
+        { \
+            lest_SUPPRESS_WUNUSED \
+            expr; \
+            lest_RESTORE_WARNINGS \
+        } \
+        catch (...) \
+        { \
+            lest::record_unexpected( lest_env, lest_LOCATION, #expr ); \
+            break; \
+        } \
+        if ( lest_env.pass() ) \
+            lest::report( lest_env.os, lest::got_none( lest_LOCATION, #expr ), lest_env.context() ); \
+    } while ( lest::is_false() )
+
+#define lest_CHECK_THROWS( expr ) \
+    do \
+    { \
+        try \
+        { \
+            lest_SUPPRESS_WUNUSED \
+            expr; \
+            lest_RESTORE_WARNINGS \
+        } \
+        catch (...) \
+        { \
+            lest_env.settle(); \
+            if ( lest_env.pass() ) \
+                lest::report( lest_env.os, lest::got{ lest_LOCATION, #expr }, lest_env.context() ); \
+            break; \
+        } \
+        lest_env.record( lest::expected{ lest_LOCATION, #expr } ); \
+    } \
+    while ( lest::is_false() )
+
+#define lest_CHECK_THROWS_AS( expr, excpt ) \
+    do \
+    { \
+        try \
+        { \
+            lest_SUPPRESS_WUNUSED \
+            expr; \
+            lest_RESTORE_WARNINGS \
+        }  \
+        catch ( excpt & ) \
+        { \
+            lest_env.settle(); \
+            if ( lest_env.pass() ) \
+            { \
+                lest::arena_scope lest_arena; \
+                lest::report( lest_env.os, lest::got{ lest_LOCATION, #expr, lest::of_type( #excpt ) }, lest_env.context() ); \
+            } \
+            break; \
+        } \
+        catch (...) {} \
+        lest_env.record( lest::expected{ lest_LOCATION, #expr, lest::of_type( #excpt ) } ); \
+    } \
+    while ( lest::is_false() )
+
+#define lest_EXPECT_RANGE_EQ( lhs, rhs ) \
+    do { \
+        try \
+        { \
+            lest::expect_range_eq( lest_env, lhs, rhs, __FILE__, __LINE__, #lhs " == " #rhs ); \
+        } \
+        catch(...) \
+        { \
+            lest::inform( lest_env, lest_LOCATION, #lhs " == " #rhs ); \
+        } \
+    } while ( lest::is_false() )
+
+#define lest_EXPECT_ALL( range, predicate ) \
+    do { \
+        try \
+        { \
+            lest::expect_all( lest_env, range, predicate, __FILE__, __LINE__, "all of " #range " satisfy " #predicate ); \
+        } \
+        catch(...) \
+        { \
+            lest::inform( lest_env, lest_LOCATION, "all of " #range " satisfy " #predicate ); \
+        } \
+    } while ( lest::is_false() )
+
+#define lest_EXPECT_RANGE_APPROX( lhs, rhs, tolerance ) \
+    do { \
+        try \
+        { \
+            lest::expect_range_approx( lest_env, lhs, rhs, tolerance, __FILE__, __LINE__, #lhs " == approx " #rhs ); \
+        } \
+        catch(...) \
+        { \
+            lest::inform( lest_env, lest_LOCATION, #lhs " == approx " #rhs ); \
+        } \
+    } while ( lest::is_false() )
+
 #define lest_UNIQUE(  name       ) lest_UNIQUE2( name, __LINE__ )
 #define lest_UNIQUE2( name, line ) lest_UNIQUE3( name, line )
 #define lest_UNIQUE3( name, line ) name ## line
@@ -324,6 +702,8 @@
 
 #define lest_FUNCTION  lest_UNIQUE(__lest_function__  )
 #define lest_REGISTRAR lest_UNIQUE(__lest_registrar__ )
+#define lest_NAME      lest_UNIQUE(__lest_name__      )
+#define lest_MANIFEST  lest_UNIQUE(__lest_manifest__  )
 
 #define lest_LOCATION  lest::location{__FILE__, __LINE__}
 
@@ -342,13 +722,70 @@ struct test
     std::function<void( env & )> behaviour;
 
 #if lest_FEATURE_AUTO_REGISTER
-    test( text name_, std::function<void( env & )> behaviour_ )
-    : name( name_), behaviour( behaviour_) {}
+    char const * file = nullptr;
+    int line = 0;
+
+    test( text name_, std::function<void( env & )> behaviour_, char const * file_ = nullptr, int line_ = 0 )
+    : name( name_), behaviour( behaviour_), file( file_ ), line( line_ ) {}
 #endif
 };
 
 using tests = std::vector<test>;
 
+// Tests to run, referring to the caller's tests rather than copying them:
+
+using schedule = std::vector<test const *>;
+
+#if lest__linker_register
+
+// Constant-initialised test records in linker section lest_registry; the
+// alignment keeps the compiler from padding records apart in the section:
+
+struct alignas( 32 ) registration
+{
+    text (*name)();
+    char const * file;
+    int line;
+    void (*behaviour)( env & );
+};
+
+extern "C" registration const __start_lest_registry[] __attribute__(( weak ));
+extern "C" registration const __stop_lest_registry[]  __attribute__(( weak ));
+
+// Registered tests, ordered by file and line. A test holds a std::string and a
+// std::function that can't be constant-initialised in the section, so they are
+// created once, on the first run:
+
+inline tests make_registered()
+{
+    std::vector<registration const *> order;
+
+    for ( auto pos = __start_lest_registry; pos != __stop_lest_registry; ++pos )
+        order.push_back( pos );
+
+    std::sort( order.begin(), order.end(), []( registration const * a, registration const * b )
+    {
+        const int cmp = std::strcmp( a->file, b->file );
+        return cmp != 0 ? cmp < 0 : a->line < b->line;
+    });
+
+    tests result;
+    result.reserve( order.size() );
+
+    for ( auto pos : order )
+        result.emplace_back( pos->name(), pos->behaviour, pos->file, pos->line );
+
+    return result;
+}
+
+inline tests const & registered()
+{
+    static const tests registry = make_registered();
+    return registry;
+}
+
+#endif
+
 #if lest_FEATURE_AUTO_REGISTER
 
 struct add_test
@@ -372,91 +809,135 @@ struct add_module
 
 #endif
 
+// Outcome of an assertion; the decomposition refers to the operands and is
+// only formatted when it is reported, within the full expression of the assertion:
+
 struct result
 {
+    using formatter = text (*)( void const * lhs, char const * op, void const * rhs );
+
     const bool passed;
-    const text decomposition;
+    void const * const lhs;
+    char const * const op;
+    void const * const rhs;
+    const formatter format;
 
     template< typename T >
-    result( T const & passed_, text decomposition_)
-    : passed( !!passed_), decomposition( decomposition_) {}
+    result( T const & passed_, void const * lhs_, char const * op_, void const * rhs_, formatter format_)
+    : passed( !!passed_), lhs( lhs_), op( op_), rhs( rhs_), format( format_) {}
+
+    text decomposition() const { return format( lhs, op, rhs ); }
 
     explicit operator bool() { return ! passed; }
 };
 
-struct location
-{
-    const text file;
-    const int line;
+// Texts of failure records: string literals are referred to as is, other
+// texts are kept in a per-thread arena that lives until the test completes;
+// the report of a passing assertion releases its texts right after:
 
-    location( text file_, int line_)
-    : file( file_), line( line_) {}
-};
+inline std::deque< text > & arena()
+{
+    static thread_local std::deque< text > kept;
+    return kept;
+}
 
-struct comment
+struct arena_scope
 {
-    const text info;
+    const std::size_t mark = arena().size();
 
-    comment( text info_) : info( info_) {}
-    explicit operator bool() { return ! info.empty(); }
+    ~arena_scope() { arena().resize( mark ); }
 };
 
-struct message : std::runtime_error
+struct chars
 {
-    const text kind;
-    const location where;
-    const comment note;
+    char const * str;
 
-    ~message() throw() {}   // GCC 4.6
+    chars( char const * str_ ) : str( str_ ) {}
+    chars( text const & str_ ) : str( keep( text( str_ ) ) ) {}
+    chars( text && str_ ) : str( keep( std::move( str_ ) ) ) {}
 
-    message( text kind_, location where_, text expr_, text note_ = "" )
-    : std::runtime_error( expr_), kind( kind_), where( where_), note( note_) {}
+    static char const * keep( text && str_ )
+    {
+        arena().emplace_back( std::move( str_ ) ); return arena().back().c_str();
+    }
 };
 
-struct failure : message
+struct location
 {
-    failure( location where_, text expr_, text decomposition_)
-    : message{ "failed", where_, expr_ + " for " + decomposition_ } {}
+    char const * file;
+    int line;
+
+    location( char const * file_, int line_)
+    : file( file_), line( line_) {}
+};
+
+struct comment
+{
+    char const * info;
+
+    comment( char const * info_) : info( info_) {}
+    comment( text const & info_) : info( chars( info_).str ) {}
+    explicit operator bool() { return info && *info; }
+};
+
+struct message
+{
+    char const * kind;
+    location where;
+    char const * expr;
+    comment note;
+    char const * detail;
+
+    message( chars kind_, location where_, chars expr_, chars note_ = "", char const * detail_ = nullptr )
+    : kind( kind_.str), where( where_), expr( expr_.str), note( note_.str), detail( detail_) {}
+
+    text what() const { return detail ? text( expr ) + " for " + detail : text( expr ); }
+};
+
+struct failure : message
+{
+    failure( location where_, chars expr_, chars decomposition_)
+    : message{ "failed", where_, expr_, "", decomposition_.str } {}
 };
 
 struct success : message
 {
 //    using message::message;   // VC is lagging here
 
-    success( text kind_, location where_, text expr_, text note_ = "" )
-    : message( kind_, where_, expr_, note_ ) {}
+    success( chars kind_, location where_, chars expr_, chars note_ = "", char const * detail_ = nullptr )
+    : message( kind_, where_, expr_, note_, detail_ ) {}
 };
 
 struct passing : success
 {
-    passing( location where_, text expr_, text decomposition_, bool zen )
-    : success( "passed", where_, expr_ + (zen ? "":" for " + decomposition_) ) {}
+    passing( location where_, chars expr_, chars decomposition_, bool zen )
+    : success( "passed", where_, expr_, "", zen ? nullptr : decomposition_.str ) {}
 };
 
 struct got_none : success
 {
-    got_none( location where_, text expr_ )
+    got_none( location where_, chars expr_ )
     : success( "passed: got no exception", where_, expr_ ) {}
 };
 
 struct got : success
 {
-    got( location where_, text expr_)
+    got( location where_, chars expr_)
     : success( "passed: got exception", where_, expr_) {}
 
-    got( location where_, text expr_, text excpt_)
-    : success( "passed: got exception " + excpt_, where_, expr_) {}
+    got( location where_, chars expr_, chars excpt_)
+    : success( "passed: got exception", where_, expr_, excpt_) {}
 };
 
 struct expected : message
 {
-    expected( location where_, text expr_, text excpt_ = "" )
+    expected( location where_, chars expr_, chars excpt_ = "" )
     : message{ "failed: didn't get exception", where_, expr_, excpt_ } {}
 };
 
 struct unexpected : message
 {
-    unexpected( location where_, text expr_, text note_ = "" )
+    unexpected( location where_, chars expr_, chars note_ = "" )
     : message{ "failed: got unexpected exception", where_, expr_, note_ } {}
 };
 
@@ -520,6 +1001,36 @@ private:
     double magnitude_;
 };
 
+// Tolerance for comparing ranges of floating point values: an element is within
+// tolerance if it is as approx with epsilon and scale, or within the absolute
+// margin, or within the number of units in the last place, if these are set:
+
+class tolerance
+{
+public:
+    tolerance()
+    : epsilon_ { std::numeric_limits<float>::epsilon() * 100 }
+    , scale_   { 1.0 }
+    , absolute_{ 0.0 }
+    , ulps_    { 0 } {}
+
+    double        epsilon () const { return epsilon_;  }
+    double        scale   () const { return scale_;    }
+    double        absolute() const { return absolute_; }
+    std::uint64_t ulps    () const { return ulps_;     }
+
+    tolerance & epsilon ( double epsilon       ) { epsilon_  = epsilon; return *this; }
+    tolerance & scale   ( double scale         ) { scale_    = scale;   return *this; }
+    tolerance & absolute( double margin        ) { absolute_ = margin;  return *this; }
+    tolerance & ulps    ( std::uint64_t count  ) { ulps_     = count;   return *this; }
+
+private:
+    double epsilon_;
+    double scale_;
+    double absolute_;
+    std::uint64_t ulps_;
+};
+
 inline bool is_false(           ) { return false; }
 inline bool is_true ( bool flag ) { return  flag; }
 
@@ -572,37 +1083,55 @@ inline char const * sfx( char const  * txt ) { return txt; }
 inline char const * sfx( char const  *      ) { return ""; }
 #endif
 
-inline std::string transformed( char chr )
+inline char const * hex_digits() { return "0123456789abcdef"; }
+
+// Append text, escaping backslash and control characters; copy runs of
+// characters that need no escape at once:
+
+inline void append_transformed( std::string & out, char const * first, char const * last )
 {
-    struct Tr { char chr; char const * str; } table[] =
-    {
-        {'\\', "\\\\" },
-        {'\r', "\\r"  }, {'\f', "\\f" },
-        {'\n', "\\n"  }, {'\t', "\\t" },
-    };
+    auto special = []( char c ) { return c == '\\' || static_cast<unsigned char>( c ) < ' '; };
 
-    for ( auto tr : table )
+    out.reserve( out.size() + static_cast<std::size_t>( last - first ) );
+
+    for ( ;; )
     {
-        if ( chr == tr.chr )
-            return tr.str;
-    }
+        char const * pos = std::find_if( first, last, special );
 
-    // The cast below helps suppress warnings ("-Wtype-limits" on GCC) on architectures where `char` is unsigned.
-    auto unprintable = [](char c){ return 0 <= static_cast<signed char>(c) && c < ' '; };
+        out.append( first, pos );
 
-    auto to_hex_string = [](char c)
-    {
-        std::ostringstream os;
-        os << "\\x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>( static_cast<unsigned char>(c) );
-        return os.str();
-    };
+        if ( pos == last )
+            return;
+
+        switch ( *pos )
+        {
+            case '\\': out += "\\\\"; break;
+            case '\r': out += "\\r";  break;
+            case '\f': out += "\\f";  break;
+            case '\n': out += "\\n";  break;
+            case '\t': out += "\\t";  break;
+            default:
+                out += "\\x";
+                out += hex_digits()[ static_cast<unsigned char>( *pos ) >> 4  ];
+                out += hex_digits()[ static_cast<unsigned char>( *pos ) & 0xf ];
+        }
+        first = pos + 1;
+    }
+}
+
+inline std::string transformed( char chr )
+{
+    std::string result; append_transformed( result, &chr, &chr + 1 ); return result;
+}
 
-    return unprintable( chr  ) ? to_hex_string( chr ) : std::string( 1, chr );
+inline std::string make_quoted_string( char quote, char const * first, char const * last )
+{
+    std::string result( 1, quote ); append_transformed( result, first, last ); result += quote; return result;
 }
 
-inline std::string make_tran_string( std::string const & txt ) { std::ostringstream os; for(auto c:txt) os << transformed(c); return os.str(); }
-inline std::string make_strg_string( std::string const & txt ) { return "\"" + make_tran_string(                 txt   ) + "\"" ; }
-inline std::string make_char_string(                char chr ) { return "\'" + make_tran_string( std::string( 1, chr ) ) + "\'" ; }
+inline std::string make_tran_string( std::string const & txt ) { std::string result; append_transformed( result, txt.data(), txt.data() + txt.size() ); return result; }
+inline std::string make_strg_string( std::string const & txt ) { return make_quoted_string( '\"', txt.data(), txt.data() + txt.size() ); }
+inline std::string make_char_string(                char chr ) { return make_quoted_string( '\'', &chr, &chr + 1 ); }
 
 inline std::string to_string( std::nullptr_t              ) { return "nullptr"; }
 inline std::string to_string( std::string     const & txt ) { return make_strg_string( txt ); }
@@ -715,41 +1244,53 @@ auto make_string( T const & item ) -> ForStreamable<T, std::string>
 template<typename T1, typename T2>
 auto make_string( std::pair<T1,T2> const & pair ) -> std::string
 {
-    std::ostringstream oss;
-    oss << "{ " << to_string( pair.first ) << ", " << to_string( pair.second ) << " }";
-    return oss.str();
+    return "{ " + to_string( pair.first ) + ", " + to_string( pair.second ) + " }";
 }
 
 template< typename TU, std::size_t N >
 struct make_tuple_string
 {
-    static std::string make( TU const & tuple )
+    static void append( std::string & out, TU const & tuple )
     {
-        std::ostringstream os;
-        os << to_string( std::get<N - 1>( tuple ) ) << ( N < std::tuple_size<TU>::value ? ", ": " ");
-        return make_tuple_string<TU, N - 1>::make( tuple ) + os.str();
+        make_tuple_string<TU, N - 1>::append( out, tuple );
+        out += to_string( std::get<N - 1>( tuple ) );
+        out += N < std::tuple_size<TU>::value ? ", ": " ";
     }
 };
 
 template< typename TU >
 struct make_tuple_string<TU, 0>
 {
-    static std::string make( TU const & ) { return ""; }
+    static void append( std::string &, TU const & ) {}
 };
 
 template< typename ...TS >
 auto make_string( std::tuple<TS...> const & tuple ) -> std::string
 {
-    return "{ " + make_tuple_string<std::tuple<TS...>, sizeof...(TS)>::make( tuple ) + "}";
+    std::string result = "{ ";
+    make_tuple_string<std::tuple<TS...>, sizeof...(TS)>::append( result, tuple );
+    result += "}";
+    return result;
+}
+
+// Format as 0x followed by the given number of hexadecimal digits:
+
+inline std::string make_hex_string( std::uintmax_t value, std::size_t digits )
+{
+    std::string result( 2 + digits, '0' );
+    result[1] = 'x';
+
+    for ( std::size_t i = result.size(); i > 2 && value != 0; value >>= 4 )
+    {
+        result[ --i ] = hex_digits()[ value & 0xf ];
+    }
+    return result;
 }
 
 template< typename T >
 inline std::string make_string( T const * ptr )
 {
-    // Note showbase affects the behavior of /integer/ output;
-    std::ostringstream os;
-    os << std::internal << std::hex << std::showbase << std::setw( 2 + 2 * sizeof(T*) ) << std::setfill('0') << reinterpret_cast<std::ptrdiff_t>( ptr );
-    return os.str();
+    return make_hex_string( reinterpret_cast<std::uintptr_t>( ptr ), 2 * sizeof(T*) );
 }
 
 template< typename C, typename R >
@@ -778,17 +1319,118 @@ auto to_string( T const & item ) -> ForNonContainerNonPointer<T, std::string>
     return make_string( item );
 }
 
+// Limits to the text of a container, 0 for no limit; see option --max-print:
+
+struct print_limits
+{
+    std::size_t count = lest_FEATURE_MAX_PRINT;
+    std::size_t bytes = lest_FEATURE_MAX_PRINT_BYTES;
+    std::size_t depth = lest_FEATURE_MAX_PRINT_DEPTH;
+    std::size_t level = 0;
+};
+
+inline print_limits & printing()
+{
+    static thread_local print_limits limits;
+    return limits;
+}
+
+// Number of elements to print while formatting a message, as before afterwards:
+
+struct print_count
+{
+    const std::size_t count;
+
+    explicit print_count( int count_ )
+    : count( printing().count ) { printing().count = static_cast<std::size_t>( count_ ); }
+
+    ~print_count() { printing().count = count; }
+
+    print_count( print_count const & ) = delete;
+    print_count & operator=( print_count const & ) = delete;
+};
+
+// Elements left unprinted, counted only if that doesn't take a walk:
+
+template< typename Iter >
+std::string more_of( Iter pos, Iter end, std::random_access_iterator_tag )
+{
+    return make_value_string( std::distance( pos, end ) ) + " more ";
+}
+
+template< typename Iter >
+std::string more_of( Iter, Iter, std::input_iterator_tag )
+{
+    return "more ";
+}
+
+// End of the text from pos on that fits before limit, not within an escape
+// sequence of append_transformed():
+
+inline std::size_t escape_boundary( std::string const & txt, std::size_t pos, std::size_t limit )
+{
+    while ( pos < limit )
+    {
+        const std::size_t next = pos + ( txt[pos] != '\\' ? 1 : pos + 1 < txt.size() && txt[pos + 1] == 'x' ? 4 : 2 );
+
+        if ( next > limit )
+            break;
+
+        pos = next;
+    }
+    return pos;
+}
+
 template< typename C >
 auto to_string( C const & cont ) -> ForContainer<C, std::string>
 {
-    std::ostringstream os;
-    os << "{ ";
-    for ( auto & x : cont )
+    print_limits & limit = printing();
+
+    if ( limit.depth > 0 && limit.level >= limit.depth )
+        return "{ ... }";
+
+    // elements get the bytes left, the limits are restored afterwards:
+
+    struct nesting
+    {
+        print_limits & limit;
+        const std::size_t bytes;
+        nesting( print_limits & limit_ ) : limit( limit_ ), bytes( limit_.bytes ) { ++limit.level; }
+        ~nesting() { --limit.level; limit.bytes = bytes; }
+    } scope( limit );
+
+    const std::size_t bytes = scope.bytes;
+
+    std::string result = "{ ";
+    std::size_t n = 0;
+    for ( auto pos = std::begin( cont ), end = std::end( cont ); pos != end; ++pos, ++n )
     {
-        os << to_string( x ) << ", ";
+        if ( ( limit.count > 0 && n >= limit.count ) || ( bytes > 0 && result.size() >= bytes ) )
+        {
+            result += "... ";
+            result += more_of( pos, end, typename std::iterator_traits<decltype( pos )>::iterator_category() );
+            break;
+        }
+        limit.bytes = bytes > 0 ? bytes - result.size() : 0;
+        const std::size_t first = result.size();
+        result += to_string( *pos );
+
+        // leave out an element that doesn't fit, unless it's the only one shown:
+
+        if ( bytes > 0 && result.size() > bytes )
+        {
+            const auto rest = n > 0 ? pos : std::next( pos );
+
+            result.resize( n > 0 ? first : escape_boundary( result, first, bytes ) );
+            result += "... ";
+            if ( rest != end )
+                result += more_of( rest, end, typename std::iterator_traits<decltype( pos )>::iterator_category() );
+            break;
+        }
+        result += ", ";
     }
-    os << "}";
-    return os.str();
+    result += "}";
+    return result;
 }
 
 #if lest_FEATURE_WSTRING
@@ -805,10 +1447,55 @@ auto to_string( std::wstring const & txt ) -> std::string
 }
 #endif
 
+// Format numbers as operator<< on a default std::ostream would,
+// without the stream's locale and buffer:
+
+template< typename T > bool is_negative( T const & value, std::true_type  /*signed*/ ) { return value < 0; }
+template< typename T > bool is_negative( T const &      , std::false_type /*signed*/ ) { return false; }
+
 template< typename T >
-auto make_value_string( T const & value ) -> std::string
+auto make_number_string( T const & value, std::true_type /*integral*/ ) -> std::string
+{
+    char buffer[ std::numeric_limits<T>::digits10 + 3 ];
+    char * const last = buffer + sizeof buffer;
+    char * first = last;
+
+    using U = typename std::make_unsigned<T>::type;
+    U magnitude = static_cast<U>( value );
+
+    const bool negative = is_negative( value, std::is_signed<T>() );
+
+    if ( negative )
+        magnitude = static_cast<U>( U() - magnitude );
+
+    do
+    {
+        *--first = static_cast<char>( '0' + magnitude % 10 );
+    }
+    while ( ( magnitude /= 10 ) != 0 );
+
+    if ( negative )
+        *--first = '-';
+
+    return std::string( first, last );
+}
+
+template< typename T >
+auto make_number_string( T const & value, std::false_type /*integral*/ ) -> std::string
 {
+#if lest_HAVE_TO_CHARS
+    char buffer[ 32 ];
+    const auto result = std::to_chars( buffer, buffer + sizeof buffer, static_cast<double>( value ), std::chars_format::general, 6 );
+    return std::string( buffer, result.ptr );
+#else
     std::ostringstream os; os << value; return os.str();
+#endif
+}
+
+template< typename T >
+auto make_value_string( T const & value ) -> std::string
+{
+    return make_number_string( value, std::is_integral<T>() );
 }
 
 inline
@@ -829,13 +1516,15 @@ auto make_memory_string( void const * item, std::size_t size ) -> std::string
 
     unsigned char const * bytes = static_cast<unsigned char const *>( item );
 
-    std::ostringstream os;
-    os << "0x" << std::setfill( '0' ) << std::hex;
+    std::string result = "0x";
+    result.reserve( 2 + 3 * size );
     for ( ; i != end; i += inc )
     {
-        os << std::setw(2) << static_cast<unsigned>( bytes[i] ) << " ";
+        result += hex_digits()[ bytes[i] >> 4  ];
+        result += hex_digits()[ bytes[i] & 0xf ];
+        result += ' ';
     }
-    return os.str();
+    return result;
 }
 
 template< typename T >
@@ -853,24 +1542,44 @@ auto to_string( approx const & appr ) -> std::string
 template< typename L, typename R >
 auto to_string( L const & lhs, std::string op, R const & rhs ) -> std::string
 {
-    std::ostringstream os; os << to_string( lhs ) << " " << op << " " << to_string( rhs ); return os.str();
+    return to_string( lhs ) + " " + op + " " + to_string( rhs );
+}
+
+template< typename L >
+text format_operand( void const * lhs, char const *, void const * )
+{
+    return to_string( *static_cast<L const *>( lhs ) );
+}
+
+template< typename L, typename R >
+text format_operands( void const * lhs, char const * op, void const * rhs )
+{
+    return to_string( *static_cast<L const *>( lhs ), op, *static_cast<R const *>( rhs ) );
 }
 
 template< typename L >
 struct expression_lhs
 {
+    using operand = typename std::remove_reference<L>::type;
+
     const L lhs;
 
     expression_lhs( L lhs_) : lhs( lhs_) {}
 
-    operator result() { return result{ !!lhs, to_string( lhs ) }; }
+    operator result() { return result{ !!lhs, std::addressof( lhs ), "", nullptr, format_operand<operand> }; }
+
+    template< typename R > result operator==( R const & rhs ) { return decompose( lhs == rhs, "==", rhs ); }
+    template< typename R > result operator!=( R const & rhs ) { return decompose( lhs != rhs, "!=", rhs ); }
+    template< typename R > result operator< ( R const & rhs ) { return decompose( lhs <  rhs, "<" , rhs ); }
+    template< typename R > result operator<=( R const & rhs ) { return decompose( lhs <= rhs, "<=", rhs ); }
+    template< typename R > result operator> ( R const & rhs ) { return decompose( lhs >  rhs, ">" , rhs ); }
+    template< typename R > result operator>=( R const & rhs ) { return decompose( lhs >= rhs, ">=", rhs ); }
 
-    template< typename R > result operator==( R const & rhs ) { return result{ lhs == rhs, to_string( lhs, "==", rhs ) }; }
-    template< typename R > result operator!=( R const & rhs ) { return result{ lhs != rhs, to_string( lhs, "!=", rhs ) }; }
-    template< typename R > result operator< ( R const & rhs ) { return result{ lhs <  rhs, to_string( lhs, "<" , rhs ) }; }
-    template< typename R > result operator<=( R const & rhs ) { return result{ lhs <= rhs, to_string( lhs, "<=", rhs ) }; }
-    template< typename R > result operator> ( R const & rhs ) { return result{ lhs >  rhs, to_string( lhs, ">" , rhs ) }; }
-    template< typename R > result operator>=( R const & rhs ) { return result{ lhs >= rhs, to_string( lhs, ">=", rhs ) }; }
+    template< typename T, typename R >
+    result decompose( T const & passed, char const * op, R const & rhs )
+    {
+        return result{ passed, std::addressof( lhs ), op, std::addressof( rhs ), format_operands<operand, R> };
+    }
 };
 
 struct expression_decomposer
@@ -938,7 +1647,7 @@ inline text pluralise( text word, int n )
 
 inline std::ostream & operator<<( std::ostream & os, comment note )
 {
-    return os << (note ? " " + note.info : "" );
+    return note ? os << " " << note.info : os;
 }
 
 inline std::ostream & operator<<( std::ostream & os, location where )
@@ -986,44 +1695,205 @@ inline bool match( texts whats, text line )
     return false;
 }
 
-inline bool select( text name, texts include )
-{
-    auto none = []( texts args ) { return args.size() == 0; };
+// Find all patterns in a test name at once: cached regular expressions, or an
+// Aho-Corasick automaton for case insensitive text; empty patterns never match:
 
 #if lest_FEATURE_REGEX_SEARCH
-    auto hidden = []( text arg ){ return match( { "\\[\\..*", "\\[hide\\]" }, arg ); };
+class matcher
+{
+public:
+    explicit matcher( texts const & patterns )
+    : res()
+    {
+        for ( auto & pattern : patterns )
+            res.emplace_back( pattern.empty() ? "(?!)" : pattern );
+    }
+
+    void operator()( text const & line, std::vector<char> & found ) const
+    {
+        for ( std::size_t id = 0; id < res.size(); ++id )
+            found[id] = std::regex_search( line, res[id] );
+    }
+
+private:
+    std::vector<std::regex> res;
+};
 #else
-    auto hidden = []( text arg ){ return match( { "[.", "[hide]" }, arg ); };
-#endif
+class matcher
+{
+public:
+    explicit matcher( texts const & patterns )
+    : next( 256, 0 ), out( 1 )
+    {
+        for ( std::size_t id = 0; id < patterns.size(); ++id )
+        {
+            if ( patterns[id].empty() )
+                continue;
+
+            std::size_t state = 0;
+            for ( auto chr : patterns[id] )
+            {
+                const std::size_t at = state * 256 + lower( chr );
+                if ( next[at] == 0 )
+                {
+                    next[at] = out.size();
+                    out.emplace_back();
+                    next.resize( next.size() + 256, 0 );
+                }
+                state = next[at];
+            }
+            out[state].push_back( id );
+        }
+
+        // complete transitions and outputs breadth first via failure links:
+
+        std::vector<std::size_t> fail( out.size(), 0 ), queue;
+
+        for ( std::size_t chr = 0; chr < 256; ++chr )
+        {
+            if ( next[chr] != 0 )
+                queue.push_back( next[chr] );
+        }
+
+        for ( std::size_t i = 0; i < queue.size(); ++i )
+        {
+            const std::size_t state = queue[i];
+            out[state].insert( out[state].end(), out[ fail[state] ].begin(), out[ fail[state] ].end() );
+
+            for ( std::size_t chr = 0; chr < 256; ++chr )
+            {
+                std::size_t & to = next[ state * 256 + chr ];
+                const std::size_t alt = next[ fail[state] * 256 + chr ];
 
-    if ( none( include ) )
+                if ( to != 0 ) { fail[to] = alt; queue.push_back( to ); }
+                else           { to = alt; }
+            }
+        }
+    }
+
+    void operator()( text const & line, std::vector<char> & found ) const
     {
-        return ! hidden( name );
+        std::fill( found.begin(), found.end(), false );
+
+        std::size_t state = 0;
+        for ( auto chr : line )
+        {
+            state = next[ state * 256 + lower( chr ) ];
+
+            for ( auto id : out[state] )
+                found[id] = true;
+        }
     }
 
-    bool any = false;
-    for ( auto pos = include.rbegin(); pos != include.rend(); ++pos )
+private:
+    static std::size_t lower( char chr )
     {
-        auto & part = *pos;
+        return static_cast<unsigned char>( std::tolower( static_cast<unsigned char>( chr ) ) );
+    }
 
-        if ( part == "@" || part == "*" )
-            return true;
+    std::vector<std::size_t> next;
+    std::vector<std::vector<std::size_t>> out;
+};
+#endif
 
-        if ( search( part, name ) )
-            return true;
+// Test specification compiled once: include[k] has pattern k, its negation
+// pattern n + k, followed by the patterns for hidden tests; unused ones are
+// empty and left to the flags for wildcards and negations:
+
+class selector
+{
+public:
+    explicit selector( texts const & include )
+    : every( flags( include, is_every ) ), negated( flags( include, is_negated ) )
+    , match( patterns( include ) ), found( 2 * include.size() + 2 ) {}
 
-        if ( '!' == part[0] )
+    bool operator()( text const & name ) const
+    {
+        const std::size_t n = every.size();
+
+        match( name, found );
+
+        const bool hidden = found[ 2 * n ] || found[ 2 * n + 1 ];
+
+        if ( n == 0 )
         {
-            any = true;
-            if ( search( part.substr(1), name ) )
-                return false;
+            return ! hidden;
         }
-        else
+
+        bool any = false;
+        for ( std::size_t k = n; k-- > 0; )
         {
-            any = false;
+            if ( every[k] || found[k] )
+                return true;
+
+            if ( negated[k] )
+            {
+                any = true;
+                if ( found[ n + k ] )
+                    return false;
+            }
+            else
+            {
+                any = false;
+            }
         }
+        return any && ! hidden;
+    }
+
+private:
+    static bool is_every( text const & part ) { return part.empty() || part == "@" || part == "*"; }
+    static bool is_negated( text const & part ) { return ! part.empty() && '!' == part[0]; }
+
+    static std::vector<char> flags( texts const & include, bool (*is)( text const & ) )
+    {
+        std::vector<char> result;
+
+        for ( auto & part : include )
+            result.push_back( is( part ) );
+
+        return result;
+    }
+
+    static texts patterns( texts const & include )
+    {
+        texts result;
+
+        for ( auto & part : include )
+            result.push_back( is_every( part ) ? text() : part );
+
+        for ( auto & part : include )
+            result.push_back( is_negated( part ) ? part.substr(1) : text() );
+
+#if lest_FEATURE_REGEX_SEARCH
+        result.push_back( "\\[\\..*" ); result.push_back( "\\[hide\\]" );
+#else
+        result.push_back( "[."       ); result.push_back( "[hide]"     );
+#endif
+        return result;
+    }
+
+    std::vector<char> every;
+    std::vector<char> negated;
+    matcher match;
+    mutable std::vector<char> found;
+};
+
+inline bool select( text name, texts include )
+{
+    return selector( include )( name );
+}
+
+inline schedule select( schedule const & specification, texts include )
+{
+    selector selected( include );
+    schedule result;
+
+    for ( auto testing : specification )
+    {
+        if ( selected( testing->name ) )
+            result.push_back( testing );
     }
-    return any && ! hidden( name );
+    return result;
 }
 
 inline int indefinite( int repeat ) { return repeat == -1; }
@@ -1045,33 +1915,92 @@ struct options
     bool verbose = false;
     bool version = false;
     int  repeat  = 1;
+    int  jobs    = 1;
+    bool isolate = false;
+    int  memory  = 0;
+    int  cpu     = 0;
+    int  shard   = 0;
+    int  shards  = 1;
+    int  print   = lest_FEATURE_MAX_PRINT;
+    int  benchmark = 1000;
+    int  threshold = 5;
+    text durations;
+    text names;
+    text expression;
+    text socket;
+    text baseline_save;
+    text baseline_compare;
+    text heap_profile;
+    int  heap_sample = 4096;
+    bool json    = false;
+    bool events  = false;
     seed_t seed  = 0;
 };
 
+class meter;
+
+// Context given with INFO() and CAPTURE(), formatted only when reported:
+
+struct info
+{
+    virtual text format() const = 0;
+
+protected:
+    ~info() {}
+};
+
 struct env
 {
     std::ostream & os;
     options opt;
     text testing;
     std::vector< text > ctx;
+    std::vector< std::pair< info const *, text > > infos;
+    std::size_t open;
+    meter * measuring;
+    int failed;
 
     env( std::ostream & out, options option )
-    : os( out ), opt( option ), testing(), ctx() {}
+    : os( out ), opt( option ), testing(), ctx(), infos(), open( 0 ), measuring( nullptr ), failed( 0 ) {}
 
     env & operator()( text test )
     {
-        clear(); testing = test; return *this;
+        clear(); testing = test; failed = 0; return *this;
+    }
+
+    void record( message const & e )
+    {
+        settle(); ++failed; report( os, e, context() );
     }
 
     bool abort() { return opt.abort; }
     bool pass()  { return opt.pass; }
     bool zen()   { return opt.zen; }
 
-    void clear() { ctx.clear(); }
+    void pause();
+    void resume();
+
+    void clear() { ctx.clear(); infos.clear(); }
+
+    // drop the texts of INFO() scopes left via an exception that was caught in the test:
+
+    void settle() { if ( infos.size() > open ) infos.resize( open ); }
     void pop()   { ctx.pop_back(); }
     void push( text proposition ) { ctx.emplace_back( proposition ); }
 
-    text context() { return testing + sections(); }
+    text context() { return testing + sections() + information(); }
+
+    text information()
+    {
+        print_count scope( opt.print );
+
+        text msg;
+        for( auto const & entry : infos )
+        {
+            msg += "\n  " + ( entry.first ? entry.first->format() : entry.second );
+        }
+        return msg;
+    }
 
     text sections()
     {
@@ -1087,225 +2016,3327 @@ struct env
     }
 };
 
-struct ctx
+// Scope of INFO() and CAPTURE(); when left via an exception, keep the formatted
+// text for the report, like a section keeps its proposition. If the test
+// catches the exception, the next INFO() or CAPTURE() drops the text, as does
+// an assertion that fails or catches an exception:
+
+template< typename F >
+struct scoped_info : info
 {
     env & environment;
-    bool once;
+    std::size_t index;
+    F formatter;
 
-    ctx( env & environment_, text proposition_ )
-    : environment( environment_), once( true )
+    scoped_info( env & environment_, F formatter_ )
+    : environment( environment_), index( 0 ), formatter( formatter_)
     {
-        environment.push( proposition_);
+        environment.settle();
+        index = environment.infos.size();
+        environment.infos.emplace_back( this, text() );
+        ++environment.open;
     }
 
-    ~ctx()
+    scoped_info( scoped_info const & ) = delete;
+
+    ~scoped_info()
     {
+        --environment.open;
+
+        if ( index >= environment.infos.size() )
+            return;
 #if lest_CPP17_OR_GREATER
         if ( std::uncaught_exceptions() == 0 )
 #else
         if ( ! std::uncaught_exception() )
 #endif
         {
-            environment.pop();
+            environment.infos.resize( index );
+        }
+        else
+        {
+            try { environment.infos[ index ] = { nullptr, format() }; }
+            catch(...) { environment.infos[ index ] = { nullptr, "{unavailable}" }; }
         }
     }
 
-    explicit operator bool() { bool result = once; once = false; return result; }
+    text format() const override { return formatter(); }
 };
 
-struct action
+template< typename F >
+scoped_info<F> make_info( env & environment, F formatter )
 {
-    std::ostream & os;
+    return { environment, formatter };
+}
 
-    action( std::ostream & out ) : os( out ) {}
+inline text info_string( text const & txt ) { return txt; }
+inline text info_string( char const * txt ) { return txt; }
 
-    action( action const & ) = delete;
-    void operator=( action const & ) = delete;
+template< typename T >
+text info_string( T const & value ) { return to_string( value ); }
 
-    operator      int() { return 0; }
-    bool        abort() { return false; }
-    action & operator()( test ) { return *this; }
-};
+inline text info_text() { return ""; }
 
-struct print : action
+template< typename T, typename... Rest >
+text info_text( T const & value, Rest const &... rest )
 {
-    print( std::ostream & out ) : action( out ) {}
+    return info_string( value ) + info_text( rest... );
+}
+
+// Split "a, f(b, c)" into "a" and "f(b, c)", and "c == ','" not:
+
+inline texts capture_names( text names )
+{
+    texts result( 1 );
+    int depth = 0;
+    char quote = 0;
+    bool escaped = false;
+    for ( char chr : names )
+    {
+        if      ( escaped                                ) escaped = false;
+        else if ( quote && chr == '\\'                   ) escaped = true;
+        else if ( quote                                  ) quote = chr == quote ? 0 : quote;
+        else if ( chr == '"' || chr == '\''              ) quote = chr;
+        else if ( chr == '(' || chr == '[' || chr == '{' ) ++depth;
+        else if ( chr == ')' || chr == ']' || chr == '}' ) --depth;
+
+        if ( chr == ',' && depth == 0 && ! quote )
+            result.emplace_back();
+        else if ( ! std::isspace( static_cast<unsigned char>( chr ) ) || ! result.back().empty() )
+            result.back() += chr;
+    }
+    return result;
+}
+
+inline text capture_text( texts const &, std::size_t ) { return ""; }
+
+template< typename T, typename... Rest >
+text capture_text( texts const & names, std::size_t i, T const & value, Rest const &... rest )
+{
+    return ( i > 0 ? ", " : "" ) + ( i < names.size() ? names[i] : text("?") ) + " := " + to_string( value ) + capture_text( names, i + 1, rest... );
+}
+
+template< typename... Values >
+text capture_text( char const * names, Values const &... values )
+{
+    return capture_text( capture_names( names ), 0, values... );
+}
+
+// Handle the outcome of an assertion, formatting its decomposition only if reported:
+
+inline text decomposition( env & output, result const & score )
+{
+    print_count scope( output.opt.print );
+    return score.decomposition();
+}
+
+inline void expect( env & output, result const & score, char const * file, int line, char const * expr )
+{
+    if ( ! score.passed )
+        throw failure{ location{ file, line }, expr, decomposition( output, score ) };
+
+    if ( output.pass() )
+    {
+        arena_scope scope;
+        report( output.os, passing{ location{ file, line }, expr, output.zen() ? "" : decomposition( output, score ), output.zen() }, output.context() );
+    }
+}
+
+inline void expect_not( env & output, result const & score, char const * file, int line, char const * expr )
+{
+    if ( score.passed )
+        throw failure{ location{ file, line }, not_expr( expr ), not_expr( decomposition( output, score ) ) };
+
+    if ( output.pass() )
+    {
+        arena_scope scope;
+        report( output.os, passing{ location{ file, line }, not_expr( expr ), output.zen() ? "" : not_expr( decomposition( output, score ) ), output.zen() }, output.context() );
+    }
+}
+
+inline void check( env & output, result const & score, char const * file, int line, char const * expr )
+{
+    if ( ! score.passed )
+        output.record( failure{ location{ file, line }, expr, decomposition( output, score ) } );
+
+    else if ( output.pass() )
+    {
+        arena_scope scope;
+        report( output.os, passing{ location{ file, line }, expr, output.zen() ? "" : decomposition( output, score ), output.zen() }, output.context() );
+    }
+}
+
+inline void check_not( env & output, result const & score, char const * file, int line, char const * expr )
+{
+    if ( score.passed )
+        output.record( failure{ location{ file, line }, not_expr( expr ), not_expr( decomposition( output, score ) ) } );
+
+    else if ( output.pass() )
+    {
+        arena_scope scope;
+        report( output.os, passing{ location{ file, line }, not_expr( expr ), output.zen() ? "" : not_expr( decomposition( output, score ) ), output.zen() }, output.context() );
+    }
+}
+
+// Report the exception that escaped from an assertion, without the texts of
+// INFO() scopes the test left via exceptions it caught before:
+
+inline void inform( env & output, location where, text expr )
+{
+    output.settle();
+    inform( where, expr );
+}
+
+// Record the exception that escaped from a soft assertion:
+
+inline void record_unexpected( env & output, location where, text expr )
+{
+    try
+    {
+        inform( where, expr );
+    }
+    catch( message const & e )
+    {
+        output.record( e );
+    }
+}
+
+// Range assertions: compare bytewise where possible, and on failure report
+// sizes, number of mismatches and a window around the first one:
+
+template< typename C >
+using element_of = typename std::decay< decltype( *std::begin( std::declval<C const &>() ) ) >::type;
+
+template< typename C >
+struct is_contiguous
+{
+    template< typename U >
+    static auto test( int ) -> decltype( std::declval<U const &>().data() + std::declval<U const &>().size(), std::true_type() );
+
+    template< typename >
+    static auto test( ... ) -> std::false_type;
+
+#ifdef _MSC_VER
+    enum { value = std::is_same< decltype( test<C>(0) ), std::true_type >::value };
+#else
+    static constexpr bool value = std::is_same< decltype( test<C>(0) ), std::true_type >::value;
+#endif
+};
+
+template< typename T, std::size_t N >
+struct is_contiguous< T[N] > : std::true_type {};
+
+template< typename L, typename R >
+struct is_bytewise_comparable : std::integral_constant< bool,
+    is_contiguous<L>::value && is_contiguous<R>::value && std::is_same< element_of<L>, element_of<R> >::value &&
+    ( std::is_integral< element_of<L> >::value || std::is_enum< element_of<L> >::value || std::is_pointer< element_of<L> >::value ) > {};
+
+template< typename C >
+auto range_data( C const & cont ) -> decltype( cont.data() ) { return cont.data(); }
+
+template< typename T, std::size_t N >
+T const * range_data( T const (&cont)[N] ) { return cont; }
+
+// Size of a range, from size() if it has one rather than by walking it:
+
+template< typename C >
+auto range_size( C const & cont, int ) -> decltype( static_cast<std::size_t>( cont.size() ) )
+{
+    return static_cast<std::size_t>( cont.size() );
+}
+
+template< typename C >
+std::size_t range_size( C const & cont, long )
+{
+    return static_cast<std::size_t>( std::distance( std::begin( cont ), std::end( cont ) ) );
+}
+
+template< typename C >
+std::size_t range_size( C const & cont )
+{
+    return range_size( cont, 0 );
+}
+
+template< typename L, typename R >
+std::size_t first_mismatch( L const & lhs, R const & rhs, std::size_t n, std::true_type /*bytewise*/ )
+{
+    auto a = range_data( lhs );
+    auto b = range_data( rhs );
+
+    std::size_t i = 0;
+    for ( const std::size_t block = 4096 / sizeof *a; i < n; i += block )
+    {
+        if ( std::memcmp( a + i, b + i, (std::min)( block, n - i ) * sizeof *a ) != 0 )
+            break;
+    }
+    for ( ; i < n && a[i] == b[i]; ++i )
+        ;
+    return (std::min)( i, n );
+}
+
+template< typename L, typename R >
+std::size_t first_mismatch( L const & lhs, R const & rhs, std::size_t n, std::false_type /*bytewise*/ )
+{
+    auto a = std::begin( lhs );
+    auto b = std::begin( rhs );
+
+    std::size_t i = 0;
+    for ( ; i < n && *a == *b; ++i, ++a, ++b )
+        ;
+    return i;
+}
+
+template< typename C >
+text range_window( C const & cont, std::size_t first, std::size_t last )
+{
+    text result = "{ ";
+    auto pos = std::begin( cont );
+    auto end = std::end( cont );
+    std::size_t i = 0;
+
+    for ( ; i < first && pos != end; ++i, ++pos )
+        ;
+    for ( ; i < last && pos != end; ++i, ++pos )
+    {
+        result += to_string( *pos );
+        result += ", ";
+    }
+    return result + "}";
+}
+
+inline text range_span( std::size_t first, std::size_t last )
+{
+    return "[" + make_value_string( first ) + ".." + make_value_string( last ) + ")";
+}
+
+const std::size_t range_context = 2;
+
+template< typename L, typename R >
+void expect_range_eq( env & output, L const & lhs, R const & rhs, char const * file, int line, char const * expr )
+{
+    const std::size_t ln = range_size( lhs );
+    const std::size_t rn = range_size( rhs );
+    const std::size_t n  = (std::min)( ln, rn );
+    const std::size_t at = first_mismatch( lhs, rhs, n, is_bytewise_comparable<L, R>() );
+
+    if ( at == n && ln == rn )
+    {
+        if ( output.pass() )
+        {
+            arena_scope scope;
+            report( output.os, passing{ location{ file, line }, expr, make_value_string( n ) + " elements equal", output.zen() }, output.context() );
+        }
+        return;
+    }
+
+    std::size_t differ = 0;
+    {
+        auto a = std::begin( lhs ); std::advance( a, static_cast<std::ptrdiff_t>( at ) );
+        auto b = std::begin( rhs ); std::advance( b, static_cast<std::ptrdiff_t>( at ) );
+
+        for ( std::size_t i = at; i < n; ++i, ++a, ++b )
+            differ += !( *a == *b );
+    }
+
+    const std::size_t first = at > range_context ? at - range_context : 0;
+    const std::size_t last  = at + range_context + 1;
 
-    print & operator()( test testing )
+    throw failure{ location{ file, line }, expr,
+        "size " + make_value_string( ln ) + " vs " + make_value_string( rn ) + ", " +
+        make_value_string( differ ) + " of " + make_value_string( n ) + " elements differ" +
+        ( at < n ? ", first at [" + make_value_string( at ) + "]" : text() ) + ": " +
+        range_span( first, (std::min)( last, (std::max)( ln, rn ) ) ) + " " + range_window( lhs, first, last ) + " vs " + range_window( rhs, first, last ) };
+}
+
+template< typename C, typename P >
+void expect_all( env & output, C const & range, P const & predicate, char const * file, int line, char const * expr )
+{
+    std::size_t n = 0, fail = 0, at = 0;
+
+    for ( auto & x : range )
+    {
+        if ( ! predicate( x ) && 0 == fail++ )
+            at = n;
+        ++n;
+    }
+
+    if ( fail == 0 )
+    {
+        if ( output.pass() )
+        {
+            arena_scope scope;
+            report( output.os, passing{ location{ file, line }, expr, make_value_string( n ) + " elements", output.zen() }, output.context() );
+        }
+        return;
+    }
+
+    const std::size_t first = at > range_context ? at - range_context : 0;
+    const std::size_t last  = at + range_context + 1;
+
+    throw failure{ location{ file, line }, expr,
+        make_value_string( fail ) + " of " + make_value_string( n ) + " elements fail, first at [" + make_value_string( at ) + "]: " +
+        range_span( first, (std::min)( last, n ) ) + " " + range_window( range, first, last ) };
+}
+
+// Approximate comparison of ranges of float or double, with a loop that
+// compilers can vectorise; on failure find the worst element:
+
+template< typename T >
+struct is_float_or_double : std::integral_constant< bool, std::is_same<T, float>::value || std::is_same<T, double>::value > {};
+
+template< typename T >
+struct ordered_bits
+{
+    using type = typename std::conditional< sizeof(T) == 4, std::int32_t, std::int64_t >::type;
+
+    static type get( T value )
+    {
+        type bits;
+        std::memcpy( &bits, &value, sizeof bits );
+        return bits < 0 ? static_cast<type>( (std::numeric_limits<type>::min)() - bits ) : bits;
+    }
+};
+
+template< typename T >
+std::uint64_t ulp_distance( T a, T b )
+{
+    const auto x = ordered_bits<T>::get( a );
+    const auto y = ordered_bits<T>::get( b );
+
+    return x < y ? static_cast<std::uint64_t>( y ) - static_cast<std::uint64_t>( x ) : static_cast<std::uint64_t>( x ) - static_cast<std::uint64_t>( y );
+}
+
+struct approx_summary
+{
+    std::size_t out = 0;
+    std::size_t worst = 0;
+    double max_abs = 0;
+    double max_rel = 0;
+};
+
+template< typename A, typename B >
+approx_summary compare_approx( A const * a, B const * b, std::size_t n, tolerance const & tol )
+{
+    approx_summary sum;
+
+    const double eps = tol.epsilon(), scale = tol.scale(), margin = tol.absolute();
+
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        const double x = static_cast<double>( a[i] );
+        const double y = static_cast<double>( b[i] );
+        const double d = std::abs( x - y );
+        const double r = d == 0 ? 0 : d / (std::max)( std::abs( x ), std::abs( y ) );
+
+        const bool within = d < eps * ( scale + (std::min)( std::abs( x ), std::abs( y ) ) ) || d <= margin;
+
+        sum.out    += ! within;
+        sum.max_abs = d > sum.max_abs ? d : sum.max_abs;
+        sum.max_rel = r > sum.max_rel ? r : sum.max_rel;
+    }
+
+    if ( tol.ulps() > 0 && sum.out > 0 )
+    {
+        sum.out = 0;
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            const double x = static_cast<double>( a[i] );
+            const double y = static_cast<double>( b[i] );
+            const double d = std::abs( x - y );
+
+            const bool within = d < eps * ( scale + (std::min)( std::abs( x ), std::abs( y ) ) ) || d <= margin || ulp_distance( a[i], static_cast<A>( b[i] ) ) <= tol.ulps();
+
+            sum.out += ! within;
+        }
+    }
+
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        if ( std::abs( static_cast<double>( a[i] ) - static_cast<double>( b[i] ) ) == sum.max_abs || a[i] != a[i] || b[i] != b[i] )
+        {
+            sum.worst = i; break;
+        }
+    }
+    return sum;
+}
+
+template< typename L, typename R >
+void expect_range_approx( env & output, L const & lhs, R const & rhs, tolerance const & tol, char const * file, int line, char const * expr )
+{
+    static_assert( is_contiguous<L>::value && is_contiguous<R>::value, "EXPECT_RANGE_APPROX() requires contiguous ranges" );
+    static_assert( is_float_or_double< element_of<L> >::value && is_float_or_double< element_of<R> >::value, "EXPECT_RANGE_APPROX() requires ranges of float or double" );
+
+    const std::size_t ln = range_size( lhs );
+    const std::size_t rn = range_size( rhs );
+    const std::size_t n  = (std::min)( ln, rn );
+
+    const approx_summary sum = compare_approx( range_data( lhs ), range_data( rhs ), n, tol );
+
+    const text errors = "max abs error " + to_string( sum.max_abs ) + " at [" + make_value_string( sum.worst ) + "]" +
+        ( n > 0 ? " (" + to_string( range_data( lhs )[ sum.worst ] ) + " vs " + to_string( range_data( rhs )[ sum.worst ] ) + ")" : text() ) +
+        ", max rel error " + to_string( sum.max_rel );
+
+    if ( sum.out == 0 && ln == rn )
+    {
+        if ( output.pass() )
+        {
+            arena_scope scope;
+            report( output.os, passing{ location{ file, line }, expr, make_value_string( n ) + " elements within tolerance, " + errors, output.zen() }, output.context() );
+        }
+        return;
+    }
+
+    throw failure{ location{ file, line }, expr,
+        "size " + make_value_string( ln ) + " vs " + make_value_string( rn ) + ", " +
+        make_value_string( sum.out ) + " of " + make_value_string( n ) + " elements out of tolerance, " + errors };
+}
+
+struct ctx
+{
+    env & environment;
+    bool once;
+
+    ctx( env & environment_, text proposition_ )
+    : environment( environment_), once( true )
+    {
+        environment.push( proposition_);
+    }
+
+    ~ctx()
     {
-        os << testing.name << "\n"; return *this;
+#if lest_CPP17_OR_GREATER
+        if ( std::uncaught_exceptions() == 0 )
+#else
+        if ( ! std::uncaught_exception() )
+#endif
+        {
+            environment.pop();
+        }
     }
+
+    explicit operator bool() { bool result = once; once = false; return result; }
+};
+
+struct action
+{
+    std::ostream & os;
+
+    action( std::ostream & out ) : os( out ) {}
+
+    action( action const & ) = delete;
+    void operator=( action const & ) = delete;
+
+    operator      int() { return 0; }
+    bool        abort() { return false; }
+    action & operator()( test const & ) { return *this; }
 };
 
 inline texts tags( text name, texts result = {} )
 {
-    auto none = std::string::npos;
-    auto lb   = name.find_first_of( "[" );
-    auto rb   = name.find_first_of( "]" );
+    for ( auto lb = name.find( '[' ); lb != text::npos; lb = name.find( '[', lb ) )
+    {
+        auto rb = name.find( ']', lb );
+
+        if ( rb == text::npos )
+            break;
+
+        result.emplace_back( name, lb, rb - lb + 1 );
+        lb = rb + 1;
+    }
+    return result;
+}
+
+inline text json_string( text const & value )
+{
+    text result = "\"";
+
+    for ( auto chr : value )
+    {
+        switch ( chr )
+        {
+            case '"' : result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n";  break;
+            case '\t': result += "\\t";  break;
+            default:
+                if ( static_cast<unsigned char>( chr ) < 0x20 )
+                    result += "\\u00" + make_hex_string( static_cast<unsigned char>( chr ), 2 ).substr( 2 );
+                else
+                    result += chr;
+        }
+    }
+    return result + "\"";
+}
+
+struct print : action
+{
+    bool json;
+    int n = 0;
+
+    print( std::ostream & out, bool json_ = false ) : action( out ), json( json_ )
+    {
+        if ( json ) { os << "["; }
+    }
+
+    print & operator()( test const & testing )
+    {
+        if ( ! json )
+        {
+            os << testing.name << "\n"; return *this;
+        }
+
+        os << ( n++ ? ",\n" : "\n" ) << "  { \"name\": " << json_string( testing.name ) << ", \"tags\": [";
+
+        auto all = tags( testing.name );
+        for ( std::size_t i = 0; i < all.size(); ++i )
+            os << ( i ? ", " : "" ) << json_string( all[i] );
+
+        os << "]";
+#if lest_FEATURE_AUTO_REGISTER
+        if ( testing.file )
+            os << ", \"file\": " << json_string( testing.file ) << ", \"line\": " << testing.line;
+#endif
+        os << " }";
+        return *this;
+    }
+
+    ~print()
+    {
+        if ( json ) { os << ( n ? "\n]\n" : "]\n" ); }
+    }
+};
+
+
+struct ptags : action
+{
+    std::map<text, int> result;
+
+    ptags( std::ostream & out ) : action( out ), result() {}
+
+    ptags & operator()( test const & testing )
+    {
+        for ( auto & tag : tags( testing.name ) )
+            ++result[ tag ];
+
+        return *this;
+    }
+
+    ~ptags()
+    {
+        for ( auto & entry : result )
+            os << std::setw(4) << entry.second << " " << entry.first << "\n";
+    }
+};
+
+struct count : action
+{
+    int n = 0;
+
+    count( std::ostream & out ) : action( out ) {}
+
+    count & operator()( test const & ) { ++n; return *this; }
+
+    ~count()
+    {
+        os << n << " selected " << pluralise("test", n) << "\n";
+    }
+};
+
+struct timer
+{
+    using time = std::chrono::high_resolution_clock;
+
+    time::time_point start = time::now();
+
+    double elapsed_seconds() const
+    {
+        return 1e-6 * static_cast<double>( std::chrono::duration_cast< std::chrono::microseconds >( time::now() - start ).count() );
+    }
+};
+
+// Benchmarks: a test tagged [.benchmark] runs its body repeatedly, in batches
+// of an iteration count that is calibrated during warm-up:
+
+inline bool is_benchmark( text const & name )
+{
+    return name.find( "[.benchmark]" ) != text::npos;
+}
+
+// Keep the compiler from optimising away a value or pending stores to memory:
+
+#if defined( __GNUC__ )
+template< typename T >
+inline void do_not_optimize( T const & value ) { asm volatile( "" : : "r,m"( value ) : "memory" ); }
+inline void clobber_memory() { asm volatile( "" : : : "memory" ); }
+#else
+template< typename T >
+inline void do_not_optimize( T const & value )
+{
+    static char const volatile * sink; sink = &reinterpret_cast<char const volatile &>( value );
+}
+inline void clobber_memory() { std::atomic_signal_fence( std::memory_order_seq_cst ); }
+#endif
+
+// Summary of samples, in seconds:
+
+struct statistics
+{
+    std::size_t samples = 0;
+    double min    = 0;
+    double median = 0;
+    double mean   = 0;
+    double sd     = 0;
+    double mad    = 0;
+};
+
+inline double median_of( std::vector<double> values )
+{
+    if ( values.empty() )
+        return 0;
+
+    const std::size_t half = values.size() / 2;
+    std::nth_element( values.begin(), values.begin() + static_cast<std::ptrdiff_t>( half ), values.end() );
+
+    if ( values.size() % 2 )
+        return values[ half ];
+
+    const double upper = values[ half ];
+    return ( *std::max_element( values.begin(), values.begin() + static_cast<std::ptrdiff_t>( half ) ) + upper ) / 2;
+}
+
+inline statistics summarise( std::vector<double> const & sample )
+{
+    statistics result;
+
+    if ( sample.empty() )
+        return result;
+
+    const double n = static_cast<double>( sample.size() );
+
+    result.samples = sample.size();
+    result.min     = *std::min_element( sample.begin(), sample.end() );
+    result.median  = median_of( sample );
+
+    double sum = 0;
+    for ( double x : sample ) sum += x;
+    result.mean = sum / n;
+
+    double squares = 0;
+    std::vector<double> deviation;
+    for ( double x : sample )
+    {
+        squares += ( x - result.mean ) * ( x - result.mean );
+        deviation.push_back( std::abs( x - result.median ) );
+    }
+    result.sd  = sample.size() > 1 ? std::sqrt( squares / ( n - 1 ) ) : 0;
+    result.mad = median_of( deviation );
+
+    return result;
+}
+
+inline text duration_string( double seconds )
+{
+    static const struct { double scale; char const * unit; } units[] = { { 1, "s" }, { 1e3, "ms" }, { 1e6, "us" }, { 1e9, "ns" } };
+
+    auto const * use = &units[0];
+    for ( auto const & unit : units )
+    {
+        use = &unit;
+        if ( std::abs( seconds ) * unit.scale >= 1 )
+            break;
+    }
+
+    std::ostringstream os;
+    os << std::fixed << std::setprecision( 3 ) << seconds * use->scale << " " << use->unit;
+    return os.str();
+}
+
+inline std::ostream & operator<<( std::ostream & os, statistics const & stats )
+{
+    return os <<
+        "min "       << duration_string( stats.min    ) <<
+        ", median "  << duration_string( stats.median ) <<
+        ", mean "    << duration_string( stats.mean   ) <<
+        ", sd "      << duration_string( stats.sd     ) <<
+        ", mad "     << duration_string( stats.mad    );
+}
+
+// Hardware and software event counters of the calling thread and the threads
+// it starts, via perf_event_open(); each event is opened on its own, so that
+// the software events remain if the hardware ones are not available. If the
+// kernel multiplexes more events than the processor has counters, a count is
+// scaled by the time its event was enabled over the time it was counting:
+
+class counters
+{
+public:
+    enum event { cycles, instructions, branch_misses, cache_references, cache_misses, page_faults, context_switches, events };
+
+    static std::vector<event> all()
+    {
+        return { cycles, instructions, branch_misses, cache_references, cache_misses, page_faults, context_switches };
+    }
+
+    static char const * name( event which )
+    {
+        static char const * const names[] = { "cycles", "instructions", "branch-misses", "cache-references", "cache-misses", "page-faults", "context-switches" };
+        return names[ which ];
+    }
+
+    explicit counters( std::vector<event> const & which = all() )
+    : since()
+    {
+        for ( auto & fd : fds )
+            fd = -1;
+
+        for ( auto which_one : which )
+            fds[ which_one ] = open( which_one );
+    }
+
+    counters( counters const & ) = delete;
+    counters & operator=( counters const & ) = delete;
+
+    ~counters()
+    {
+#if lest__perf_counters
+        for ( auto fd : fds )
+            if ( fd >= 0 ) ::close( fd );
+#endif
+    }
+
+    bool available( event which ) const { return fds[ which ] >= 0; }
+
+    bool any() const
+    {
+        return std::any_of( std::begin( fds ), std::end( fds ), []( int fd ) { return fd >= 0; } );
+    }
+
+    void enable()  { control( PERF_ENABLE  ); }
+    void disable() { control( PERF_DISABLE ); }
+
+    // a reset clears the counts, but not the times, so keep those:
+
+    void reset()
+    {
+        control( PERF_RESET );
+
+        for ( int i = 0; i < events; ++i )
+            since[ i ] = read( static_cast<event>( i ) );
+    }
+
+    std::uint64_t value( event which ) const
+    {
+        const reading now = read( which );
+        const std::uint64_t enabled = now.enabled - since[ which ].enabled;
+        const std::uint64_t running = now.running - since[ which ].running;
+
+        if ( running == 0 || running >= enabled )
+            return now.count;
+
+        return static_cast<std::uint64_t>( static_cast<double>( now.count ) * static_cast<double>( enabled ) / static_cast<double>( running ) );
+    }
+
+    // "cycles 1234, instructions 5678, ...", each value divided by the given number:
+
+    text summary( double divisor = 1 ) const
+    {
+        std::ostringstream os;
+        if ( divisor == 1 )
+            os << std::setprecision( 0 ) << std::fixed;
+
+        for ( int i = 0; i < events; ++i )
+        {
+            const auto which = static_cast<event>( i );
+
+            if ( available( which ) )
+                os << ( os.tellp() > 0 ? ", " : "" ) << name( which ) << " " << static_cast<double>( value( which ) ) / divisor;
+        }
+        return os.str();
+    }
+
+private:
+    struct reading
+    {
+        std::uint64_t count;
+        std::uint64_t enabled;  // nanoseconds
+        std::uint64_t running;
+    };
+
+#if lest__perf_counters
+    enum request { PERF_RESET = PERF_EVENT_IOC_RESET, PERF_ENABLE = PERF_EVENT_IOC_ENABLE, PERF_DISABLE = PERF_EVENT_IOC_DISABLE };
+
+    static int open( event which )
+    {
+        static const std::uint32_t types[] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE, PERF_TYPE_SOFTWARE };
+        static const std::uint64_t configs[] =
+        {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_SW_PAGE_FAULTS, PERF_COUNT_SW_CONTEXT_SWITCHES,
+        };
+
+        perf_event_attr attr;
+        std::memset( &attr, 0, sizeof attr );
+        attr.size           = sizeof attr;
+        attr.type           = types  [ which ];
+        attr.config         = configs[ which ];
+        attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled       = 1;
+        attr.inherit        = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+
+        return static_cast<int>( ::syscall( SYS_perf_event_open, &attr, 0, -1, -1, 0 ) );
+    }
+
+    reading read( event which ) const
+    {
+        reading result{ 0, 0, 0 };
+
+        if ( fds[ which ] < 0 || ::read( fds[ which ], &result, sizeof result ) != static_cast<ssize_t>( sizeof result ) )
+            return { 0, 0, 0 };
+
+        return result;
+    }
+
+    void control( request what )
+    {
+        for ( auto fd : fds )
+            if ( fd >= 0 ) ::ioctl( fd, static_cast<unsigned long>( what ), 0 );
+    }
+#else
+    enum request { PERF_RESET, PERF_ENABLE, PERF_DISABLE };
+
+    static int open( event ) { return -1; }
+
+    reading read( event ) const { return { 0, 0, 0 }; }
+
+    void control( request ) {}
+#endif
+
+    int fds[ events ];
+    reading since[ events ];
+};
+
+// Allocation accounting, active if lest_alloc.hpp replaces operator new and
+// delete in the test program: allocations and bytes are counted per thread in
+// a slot of its own and summed when read, live bytes and their peak globally:
+
+struct alignas( 64 ) allocation_slot
+{
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::uint64_t> bytes;
+};
+
+struct allocation_registry
+{
+    enum { slots = 64 };
+
+    allocation_slot slot[ slots ];
+    std::atomic<std::size_t> threads;
+    std::atomic<std::int64_t> live;
+    std::atomic<std::int64_t> peak;
+    std::atomic<std::size_t> sampling;  // mean bytes between heap profile samples, 0: off
+    std::atomic<bool> installed;
+};
+
+// Trivially constructible, hence zero-initialised before any allocation:
+
+inline allocation_registry & allocation_counters()
+{
+    static allocation_registry registry;
+    return registry;
+}
+
+inline allocation_slot & allocation_slot_of_thread()
+{
+    static thread_local std::size_t index = allocation_counters().threads.fetch_add( 1, std::memory_order_relaxed ) % allocation_registry::slots;
+    return allocation_counters().slot[ index ];
+}
+
+inline void count_allocation( std::size_t size )
+{
+    allocation_slot & slot = allocation_slot_of_thread();
+    slot.count.fetch_add( 1, std::memory_order_relaxed );
+    slot.bytes.fetch_add( size, std::memory_order_relaxed );
+
+    allocation_registry & registry = allocation_counters();
+    const std::int64_t live = registry.live.fetch_add( static_cast<std::int64_t>( size ), std::memory_order_relaxed ) + static_cast<std::int64_t>( size );
+
+    for ( std::int64_t peak = registry.peak.load( std::memory_order_relaxed ); live > peak; )
+    {
+        if ( registry.peak.compare_exchange_weak( peak, live, std::memory_order_relaxed ) )
+            break;
+    }
+}
+
+inline void count_deallocation( std::size_t size )
+{
+    allocation_counters().live.fetch_sub( static_cast<std::int64_t>( size ), std::memory_order_relaxed );
+}
+
+inline bool allocations_counted()
+{
+    return allocation_counters().installed.load();
+}
+
+struct allocation_counts
+{
+    std::uint64_t count;
+    std::uint64_t bytes;
+    std::uint64_t peak;     // live bytes above those at the start
+};
+
+inline allocation_counts allocations_so_far()
+{
+    allocation_counts result{ 0, 0, 0 };
+
+    for ( auto & slot : allocation_counters().slot )
+    {
+        result.count += slot.count.load( std::memory_order_relaxed );
+        result.bytes += slot.bytes.load( std::memory_order_relaxed );
+    }
+    return result;
+}
+
+// Allocations from construction on, of all threads; scopes may nest, but the
+// peak is shared, so they must not overlap otherwise, as under --jobs:
+
+class allocation_scope
+{
+public:
+    allocation_scope()
+    : start( allocations_so_far() )
+    , live( allocation_counters().live.load() )
+    , peak( allocation_counters().peak.exchange( live ) ) {}
+
+    allocation_scope( allocation_scope const & ) = delete;
+    allocation_scope & operator=( allocation_scope const & ) = delete;
+
+    ~allocation_scope()
+    {
+        std::atomic<std::int64_t> & current = allocation_counters().peak;
+
+        for ( std::int64_t now = current.load(); peak > now; )
+        {
+            if ( current.compare_exchange_weak( now, peak ) )
+                break;
+        }
+    }
+
+    allocation_counts counts() const
+    {
+        const allocation_counts now = allocations_so_far();
+        const std::int64_t above = allocation_counters().peak.load() - live;
+
+        return { now.count - start.count, now.bytes - start.bytes, static_cast<std::uint64_t>( (std::max)( std::int64_t( 0 ), above ) ) };
+    }
+
+private:
+    allocation_counts start;
+    std::int64_t live;
+    std::int64_t peak;
+};
+
+inline std::ostream & operator<<( std::ostream & os, allocation_counts const & counts )
+{
+    return os << "allocations " << counts.count << ", " << counts.bytes << " bytes, peak " << counts.peak << " bytes";
+}
+
+template< typename F >
+void expect_max_allocs( env & output, std::uint64_t limit, F region, char const * file, int line, char const * expr, char const * bound )
+{
+    const text proposition = text( "allocations( " ) + expr + " ) <= " + bound;
+
+    if ( ! allocations_counted() )
+        throw failure{ location{ file, line }, proposition, "allocations not counted, include lest/lest_alloc.hpp" };
+
+    std::uint64_t count = 0;
+    {
+        allocation_scope scope;
+        region();
+        count = scope.counts().count;
+    }
+
+    if ( count > limit )
+        throw failure{ location{ file, line }, proposition, to_string( count ) + " <= " + to_string( limit ) };
+
+    if ( output.pass() )
+    {
+        arena_scope scope;
+        report( output.os, passing{ location{ file, line }, proposition, to_string( count ) + " <= " + to_string( limit ), output.zen() }, output.context() );
+    }
+}
+
+// Heap profile of a test with option --heap-profile: lest_alloc.hpp offers
+// each allocation for sampling and a sampled allocation is taken with the
+// probability that one of its bytes is the next of a Poisson process with the
+// mean interval of option --heap-sample. A sample keeps the backtrace and the
+// allocations and bytes it stands for. Samples still live after the test
+// returns are reported as probable leaks:
+
+#if lest__heap_profile
+
+// Memory of the profiler itself, from malloc() so that it isn't counted:
+
+template< typename T >
+struct raw_allocator
+{
+    using value_type = T;
+
+    raw_allocator() = default;
+
+    template< typename U >
+    raw_allocator( raw_allocator<U> const & ) {}
+
+    T * allocate( std::size_t n )
+    {
+        if ( void * ptr = std::malloc( n * sizeof( T ) ) )
+            return static_cast<T *>( ptr );
+        throw std::bad_alloc();
+    }
+
+    void deallocate( T * ptr, std::size_t ) { std::free( ptr ); }
+
+    template< typename U > bool operator==( raw_allocator<U> const & ) const { return true;  }
+    template< typename U > bool operator!=( raw_allocator<U> const & ) const { return false; }
+};
+
+using frames = std::vector< void *, raw_allocator< void * > >;
+
+struct heap_weight
+{
+    double count;
+    double bytes;
+};
+
+struct heap_sample
+{
+    frames stack;
+    heap_weight weight;
+};
+
+struct heap_profile
+{
+    enum { depth = 64 };
+
+    std::mutex mutex;
+    frames base;
+    std::map< frames, heap_weight, std::less< frames >, raw_allocator< std::pair< frames const, heap_weight > > > sites;
+    std::map< void const *, heap_sample, std::less< void const * >, raw_allocator< std::pair< void const * const, heap_sample > > > live;
+    std::map< text, double > folded;
+    bool ready = false;     // a test returned, its profile is not yet reported
+};
+
+inline heap_profile & heap_profiles()
+{
+    static heap_profile profile;
+    return profile;
+}
+
+// Bytes left until the next sample and the state of the random generator of
+// this thread, and whether the profiler itself is running on it:
+
+struct heap_sampler
+{
+    std::int64_t countdown;
+    std::uint64_t state;
+    bool started;
+    bool busy;
+};
+
+inline heap_sampler & heap_sampler_of_thread()
+{
+    static thread_local heap_sampler sampler;
+    return sampler;
+}
+
+inline std::int64_t next_sample_interval( heap_sampler & sampler, std::size_t mean )
+{
+    sampler.state ^= sampler.state << 13;
+    sampler.state ^= sampler.state >> 7;
+    sampler.state ^= sampler.state << 17;
+
+    const double uniform = static_cast<double>( ( sampler.state >> 11 ) + 1 ) / 9007199254740993.0;
+
+    return static_cast<std::int64_t>( -std::log( uniform ) * static_cast<double>( mean ) ) + 1;
+}
+
+class heap_busy
+{
+public:
+    heap_busy() : sampler( heap_sampler_of_thread() ) { sampler.busy = true; }
+    ~heap_busy() { sampler.busy = false; }
+
+    heap_busy( heap_busy const & ) = delete;
+    heap_busy & operator=( heap_busy const & ) = delete;
+
+private:
+    heap_sampler & sampler;
+};
+
+lest_NOINLINE inline frames backtrace_frames()
+{
+    void * buffer[ heap_profile::depth ];
+    const int n = ::backtrace( buffer, heap_profile::depth );
+
+    return frames( buffer, buffer + n );
+}
+
+// Return true if the allocation is sampled; lest_alloc.hpp then reports its
+// release via forget_allocation(). The stack of the sample starts at caller,
+// the return address of operator new:
+
+lest_NOINLINE inline bool sample_allocation( void const * ptr, std::size_t size, void const * caller )
+{
+    const std::size_t mean = allocation_counters().sampling.load( std::memory_order_relaxed );
+
+    if ( mean == 0 )
+        return false;
+
+    heap_sampler & sampler = heap_sampler_of_thread();
+
+    if ( sampler.busy )
+        return false;
+
+    if ( ! sampler.started )
+    {
+        sampler.state     = reinterpret_cast<std::uintptr_t>( &sampler ) | 1;
+        sampler.countdown = next_sample_interval( sampler, mean );
+        sampler.started   = true;
+    }
+
+    sampler.countdown -= static_cast<std::int64_t>( size );
+
+    if ( sampler.countdown > 0 )
+        return false;
+
+    heap_busy busy;
+
+    sampler.countdown = next_sample_interval( sampler, mean );
+
+    const double probability = 1 - std::exp( -static_cast<double>( size ) / static_cast<double>( mean ) );
+    const heap_weight weight{ 1 / probability, static_cast<double>( size ) / probability };
+
+    frames stack = backtrace_frames();
+
+    // Drop the frames of the profiler and of operator new, however inlined:
+
+    auto first = std::find( stack.begin(), stack.end(), caller );
+
+    if ( first != stack.end() )
+        stack.erase( stack.begin(), first );
+
+    heap_profile & profile = heap_profiles();
+    std::lock_guard<std::mutex> lock( profile.mutex );
+
+    heap_weight & site = profile.sites[ stack ];
+    site.count += weight.count;
+    site.bytes += weight.bytes;
+
+    profile.live[ ptr ] = heap_sample{ std::move( stack ), weight };
+    return true;
+}
+
+inline void forget_allocation( void const * ptr )
+{
+    heap_busy busy;
+
+    heap_profile & profile = heap_profiles();
+    std::lock_guard<std::mutex> lock( profile.mutex );
+
+    profile.live.erase( ptr );
+}
+
+inline text frame_name( void * address )
+{
+    Dl_info info;
+    std::ostringstream os;
+
+    if ( ! dladdr( address, &info ) )
+    {
+        os << address;
+    }
+    else if ( info.dli_sname )
+    {
+        int status = 0;
+        char * demangled = abi::__cxa_demangle( info.dli_sname, nullptr, nullptr, &status );
+        os << ( status == 0 && demangled ? demangled : info.dli_sname );
+        std::free( demangled );
+    }
+    else
+    {
+        // module and offset, for addr2line:
+        const text module = info.dli_fname ? info.dli_fname : "";
+        os << module.substr( module.find_last_of( '/' ) + 1 ) << "+0x" << std::hex << ( static_cast<char *>( address ) - static_cast<char *>( info.dli_fbase ) );
+    }
+    return os.str();
+}
+
+inline bool is_library_frame( text const & name )
+{
+    return name.compare( 0, 5, "std::" ) == 0 || name.compare( 0, 11, "__gnu_cxx::" ) == 0;
+}
+
+// Frame names of the test's part of a stack, outermost first: without the
+// frames that it shares with the stack of enact(), such as of std::function:
+
+inline texts site_names( frames const & stack, frames const & base )
+{
+    auto outer = stack.size();
+    auto below = base.size();
+
+    if ( stack.size() < heap_profile::depth )
+    {
+        while ( outer > 0 && below > 0 && stack[ outer - 1 ] == base[ below - 1 ] )
+        {
+            --outer; --below;
+        }
+        if ( outer > 0 && below > 0 )
+            --outer;
+    }
+
+    texts names;
+    for ( std::size_t i = 0; i < outer; ++i )
+        names.push_back( frame_name( stack[ i ] ) );
+
+    while ( ! names.empty() && is_library_frame( names.back() ) )
+        names.pop_back();
+
+    return texts( names.rbegin(), names.rend() );
+}
+
+// The innermost frame outside the standard library and its callers:
+
+inline text site_string( texts const & names, std::size_t count = 3 )
+{
+    auto first = std::find_if_not( names.rbegin(), names.rend(), is_library_frame );
+
+    if ( first == names.rend() )
+        first = names.rbegin();
+
+    text result;
+    for ( auto pos = first; pos != names.rend() && count > 0; ++pos, --count )
+        result += ( result.empty() ? "" : " < " ) + *pos;
+
+    return result.empty() ? "[unknown]" : result;
+}
+
+inline text folded_string( text name, texts const & names )
+{
+    std::replace( name.begin(), name.end(), ';', ',' );
+
+    for ( auto & frame : names )
+    {
+        text step = frame;
+        std::replace( step.begin(), step.end(), ';', ',' );
+        name += ";" + step;
+    }
+    return name;
+}
+
+inline heap_weight total_of( std::vector< std::pair< text, heap_weight > > const & table )
+{
+    heap_weight total{ 0, 0 };
+    for ( auto & row : table )
+    {
+        total.count += row.second.count;
+        total.bytes += row.second.bytes;
+    }
+    return total;
+}
+
+inline void report_sites( std::ostream & os, text const & name, char const * what, std::vector< std::pair< text, heap_weight > > table )
+{
+    std::sort( table.begin(), table.end(), []( std::pair< text, heap_weight > const & a, std::pair< text, heap_weight > const & b ) { return a.second.bytes > b.second.bytes; } );
+
+    const heap_weight total = total_of( table );
+
+    os << name << ": " << what << ", about " << std::llround( total.count ) << " " << pluralise( "allocation", static_cast<int>( std::llround( total.count ) ) ) << " of " << std::llround( total.bytes ) << " bytes\n";
+
+    if ( table.empty() )
+        return;
+
+    os << "  " << std::setw(12) << "bytes" << std::setw(8) << "allocs" << "  site\n";
+
+    for ( std::size_t i = 0; i < table.size() && i < 10; ++i )
+        os << "  " << std::setw(12) << std::llround( table[i].second.bytes ) << std::setw(8) << std::llround( table[i].second.count ) << "  " << table[i].first << "\n";
+}
+
+// Sample the allocations of a test while in scope:
+
+class heap_profiling
+{
+public:
+    explicit heap_profiling( env & output )
+    : active( ! output.opt.heap_profile.empty() )
+    {
+        if ( ! active )
+            return;
+
+        heap_busy busy;
+        heap_profile & profile = heap_profiles();
+        std::lock_guard<std::mutex> lock( profile.mutex );
+
+        profile.base = backtrace_frames();
+        profile.sites.clear();
+        profile.live.clear();
+        profile.ready = false;
+
+        allocation_counters().sampling = static_cast<std::size_t>( output.opt.heap_sample );
+    }
+
+    ~heap_profiling()
+    {
+        if ( active )
+            allocation_counters().sampling = 0;
+    }
+
+    heap_profiling( heap_profiling const & ) = delete;
+    heap_profiling & operator=( heap_profiling const & ) = delete;
+
+    // The test returned, stop sampling:
+
+    void done()
+    {
+        if ( ! active )
+            return;
+
+        allocation_counters().sampling = 0;
+
+        heap_profile & profile = heap_profiles();
+        std::lock_guard<std::mutex> lock( profile.mutex );
+        profile.ready = true;
+    }
+
+private:
+    bool active;
+};
+
+// Report the top allocating sites and the samples still live of the test that
+// returned last; call it after reading the test's allocation counts, as the
+// report allocates:
+
+inline void report_heap_profile( std::ostream & os, text const & name )
+{
+    heap_busy busy;
+    heap_profile & profile = heap_profiles();
+    std::lock_guard<std::mutex> lock( profile.mutex );
+
+    if ( ! profile.ready )
+        return;
+
+    auto add = []( heap_weight & total, heap_weight const & weight )
+    {
+        total.count += weight.count;
+        total.bytes += weight.bytes;
+    };
+
+    profile.ready = false;
+
+    std::map< text, heap_weight > sites, leaks;
+
+    for ( auto & site : profile.sites )
+    {
+        const texts names = site_names( site.first, profile.base );
+
+        add( sites[ site_string( names ) ], site.second );
+        profile.folded[ folded_string( name, names ) ] += site.second.bytes;
+    }
+
+    for ( auto & sample : profile.live )
+    {
+        add( leaks[ site_string( site_names( sample.second.stack, profile.base ) ) ], sample.second.weight );
+    }
+
+    report_sites( os, name, "heap profile", { sites.begin(), sites.end() } );
+
+    if ( ! leaks.empty() )
+        report_sites( os, name, "probable leaks", { leaks.begin(), leaks.end() } );
+}
+
+// Save the sampled bytes per stack for flame graph tools, one line per stack:
+// test;outermost;...;innermost bytes
+
+inline void save_heap_profile( text filename )
+{
+    std::ofstream out( filename );
+
+    if ( ! out )
+        throw std::runtime_error( "cannot write heap profile to '" + filename + "'" );
+
+    for ( auto & stack : heap_profiles().folded )
+        out << stack.first << " " << std::llround( stack.second ) << "\n";
+
+    heap_profiles().folded.clear();
+}
+
+#else // lest__heap_profile
+
+inline bool sample_allocation( void const *, std::size_t, void const * ) { return false; }
+
+inline void forget_allocation( void const * ) {}
+
+class heap_profiling
+{
+public:
+    explicit heap_profiling( env & ) {}
+    void done() {}
+};
+
+inline void report_heap_profile( std::ostream &, text const & ) {}
+
+inline void save_heap_profile( text ) {}
+
+#endif // lest__heap_profile
+
+// Clock time of the current benchmark batch, less the time it was paused:
+
+class meter
+{
+public:
+    using clock = timer::time;
+
+    explicit meter( counters * events_ = nullptr ) : events( events_ ) {}
+
+    void pause()
+    {
+        if ( ! paused )
+        {
+            paused = true; ++pauses; paused_at = clock::now();
+            if ( events ) events->disable();
+        }
+    }
+
+    void resume()
+    {
+        if ( paused )
+        {
+            if ( events ) events->enable();
+            idle += clock::now() - paused_at; paused = false;
+        }
+    }
+
+    double seconds_since( clock::time_point start, double overhead ) const
+    {
+        const double total = std::chrono::duration<double>( clock::now() - start - idle ).count();
+        return (std::max)( 0.0, total - overhead * static_cast<double>( 1 + pauses ) );
+    }
+
+private:
+    counters * events;
+    bool paused = false;
+    std::size_t pauses = 0;
+    clock::time_point paused_at;
+    clock::duration idle = clock::duration::zero();
+};
+
+inline void env::pause()  { if ( measuring ) measuring->pause();  }
+inline void env::resume() { if ( measuring ) measuring->resume(); }
+
+// Cost of reading the clock, subtracted from each batch:
+
+inline double clock_overhead()
+{
+    static const double overhead = []
+    {
+        double best = 1;
+        for ( int round = 0; round < 10; ++round )
+        {
+            const auto start = meter::clock::now();
+            for ( int i = 0; i < 100; ++i )
+                do_not_optimize( meter::clock::now() );
+            best = (std::min)( best, std::chrono::duration<double>( meter::clock::now() - start ).count() / 101 );
+        }
+        return best;
+    }();
+    return overhead;
+}
+
+struct measurement
+{
+    std::size_t iterations;
+    statistics stats;
+    text events;
+};
+
+// Warm up for a tenth of the budget, doubling the iteration count until a batch
+// takes a hundredth of it, but no longer than the budget and without overflowing
+// the count, then sample at least ten batches, until the mean is known within
+// one percent or the budget is spent:
+
+inline measurement benchmark( test const & testing, env & output )
+{
+    const double budget   = 1e-3 * output.opt.benchmark;
+    const double overhead = clock_overhead();
+
+    std::unique_ptr<counters> events( output.opt.events ? new counters() : nullptr );
+    bool counting = false;
+
+    auto batch = [&]( std::size_t iterations ) -> double
+    {
+        meter measure( counting ? events.get() : nullptr );
+        output.measuring = &measure;
+        if ( counting ) events->enable();
+        const auto start = meter::clock::now();
+
+        for ( std::size_t i = 0; i < iterations; ++i )
+            testing.behaviour( output );
+
+        const double seconds = measure.seconds_since( start, overhead );
+        if ( counting ) events->disable();
+        output.measuring = nullptr;
+        return seconds;
+    };
+
+    struct unmeasure
+    {
+        env & output;
+        ~unmeasure() { output.measuring = nullptr; }
+    } guard{ output };
+
+    const std::size_t most = (std::numeric_limits<std::size_t>::max)() / 2;
+
+    std::size_t iterations = 1;
+    timer warmup;
+
+    for ( double seconds = batch( iterations ); warmup.elapsed_seconds() < budget; seconds = batch( iterations ) )
+    {
+        if ( seconds < budget / 100 && iterations <= most )
+            iterations *= 2;
+        else if ( warmup.elapsed_seconds() >= budget / 10 )
+            break;
+    }
+
+    const std::size_t least = 10;
+
+    std::vector<double> sample;
+    timer sampling;
+
+    if ( events )
+    {
+        events->reset(); counting = true;
+    }
+
+    for ( double sum = 0, squares = 0; ; )
+    {
+        const double x = batch( iterations ) / static_cast<double>( iterations );
+        sample.push_back( x ); sum += x; squares += x * x;
+
+        const double n    = static_cast<double>( sample.size() );
+        const double mean = sum / n;
+        const double sd   = n > 1 ? std::sqrt( (std::max)( 0.0, ( squares - n * mean * mean ) / ( n - 1 ) ) ) : 0;
+
+        if ( sample.size() >= 1000 || ( sample.size() >= least && sampling.elapsed_seconds() >= budget ) )
+            break;
+
+        if ( sample.size() >= least && sd <= 0.01 * mean * std::sqrt( n ) )
+            break;
+    }
+
+    const double runs = static_cast<double>( iterations * sample.size() );
+
+    return { iterations, summarise( sample ), events ? events->summary( runs ) : text() };
+}
+
+// Run a test, or measure a benchmark and return its statistics:
+
+inline statistics enact( test const & testing, env & output )
+{
+    output( testing.name );
+
+    if ( ! is_benchmark( testing.name ) )
+    {
+        heap_profiling profiling( output );
+        testing.behaviour( output );
+        profiling.done();
+        return statistics();
+    }
+
+    const measurement result = benchmark( testing, output );
+
+    output.os << testing.name << ": " << result.stats << " (" << result.stats.samples << " samples of " << result.iterations << " " << pluralise( "iteration", static_cast<int>( result.iterations ) ) << ")\n";
+
+    if ( ! result.events.empty() )
+        output.os << testing.name << ": per iteration " << result.events << "\n";
+
+    return result.stats;
+}
+
+// Count the instructions the region executes, including threads it starts;
+// without an instruction counter, e.g. for lack of permission, only run it:
+
+template< typename F >
+void expect_instructions_below( env & output, std::uint64_t limit, F region, char const * file, int line, char const * expr, char const * bound )
+{
+    counters events( { counters::instructions } );
+
+    if ( ! events.available( counters::instructions ) )
+    {
+        region();
+
+        if ( output.pass() )
+            report( output.os, message{ "passed: no instruction counter", location{ file, line }, expr }, output.context() );
+        return;
+    }
+
+    events.reset(); events.enable();
+    region();
+    events.disable();
+
+    const std::uint64_t count = events.value( counters::instructions );
+    const text proposition = text( "instructions( " ) + expr + " ) < " + bound;
+
+    if ( count >= limit )
+        throw failure{ location{ file, line }, proposition, to_string( count ) + " < " + to_string( limit ) };
+
+    if ( output.pass() )
+    {
+        arena_scope scope;
+        report( output.os, passing{ location{ file, line }, proposition, to_string( count ) + " < " + to_string( limit ), output.zen() }, output.context() );
+    }
+}
+
+// Speedup of a candidate over a baseline implementation: runs of both alternate
+// in pairs, in the order AB, BA, AB, ..., to cancel drift of the processor's
+// frequency and temperature. The speedup is the ratio of the mean times per
+// run, its 90% confidence interval is taken by bootstrap resampling the pairs:
+
+struct speedup
+{
+    double ratio;
+    double low;
+    double high;
+    std::size_t pairs;
+};
+
+template< typename F >
+auto run_kept( F & f ) -> typename std::enable_if< std::is_void< decltype( f() ) >::value >::type
+{
+    f();
+}
+
+template< typename F >
+auto run_kept( F & f ) -> typename std::enable_if< ! std::is_void< decltype( f() ) >::value >::type
+{
+    do_not_optimize( f() );
+}
+
+template< typename F >
+double seconds_per_run( F & f, std::size_t runs )
+{
+    timer t;
+    for ( std::size_t i = 0; i < runs; ++i )
+        run_kept( f );
+
+    return t.elapsed_seconds() / static_cast<double>( runs );
+}
+
+// Double the number of runs until a batch takes at least the given time:
+
+template< typename F >
+std::size_t runs_per_batch( F & f, double seconds )
+{
+    std::size_t runs = 1;
+
+    for ( ; runs < ( std::size_t( 1 ) << 30 ) && seconds_per_run( f, runs ) * static_cast<double>( runs ) < seconds; runs *= 2 ) {}
+
+    return runs;
+}
+
+inline speedup bootstrap_speedup( std::vector<double> const & baseline, std::vector<double> const & candidate )
+{
+    const std::size_t n = baseline.size();
+
+    auto ratio = []( double a, double b ) { return b > 0 ? a / b : std::numeric_limits<double>::infinity(); };
+
+    std::mt19937 generator( 5489u );
+    std::uniform_int_distribution<std::size_t> pick( 0, n - 1 );
+    std::vector<double> ratios( 2000 );
+
+    for ( auto & r : ratios )
+    {
+        double a = 0, b = 0;
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            const std::size_t k = pick( generator );
+            a += baseline[k]; b += candidate[k];
+        }
+        r = ratio( a, b );
+    }
+    std::sort( ratios.begin(), ratios.end() );
+
+    const double a = std::accumulate( baseline.begin(), baseline.end(), 0.0 );
+    const double b = std::accumulate( candidate.begin(), candidate.end(), 0.0 );
+
+    return { ratio( a, b ), ratios[ ratios.size() / 20 ], ratios[ ratios.size() - 1 - ratios.size() / 20 ], n };
+}
+
+template< typename F, typename G >
+speedup measure_speedup( F & baseline, G & candidate, double budget )
+{
+    const double batch = (std::max)( budget / 200, 1e-3 );
+
+    const std::size_t runs_a = runs_per_batch( baseline , batch );
+    const std::size_t runs_b = runs_per_batch( candidate, batch );
+
+    std::vector<double> a, b;
+    timer sampling;
+
+    while ( a.size() < 1000 && ( a.size() < 10 || sampling.elapsed_seconds() < budget ) )
+    {
+        if ( a.size() % 2 == 0 )
+        {
+            a.push_back( seconds_per_run( baseline , runs_a ) );
+            b.push_back( seconds_per_run( candidate, runs_b ) );
+        }
+        else
+        {
+            b.push_back( seconds_per_run( candidate, runs_b ) );
+            a.push_back( seconds_per_run( baseline , runs_a ) );
+        }
+    }
+    return bootstrap_speedup( a, b );
+}
+
+inline text speedup_string( speedup const & result )
+{
+    std::ostringstream os;
+    os << std::setprecision(3) << "speedup " << result.ratio << ", 90% interval " << result.low << " .. " << result.high << " of " << result.pairs << " pairs";
+    return os.str();
+}
+
+// Expect the candidate to be faster than the baseline by at least the given
+// factor, at 95% confidence, i.e. the lower end of the interval:
+
+template< typename F, typename G >
+void expect_faster( env & output, F baseline, G candidate, double minimum, char const * file, int line, char const * base, char const * cand, char const * bound )
+{
+    const speedup result = measure_speedup( baseline, candidate, 1e-3 * output.opt.benchmark );
+    const text proposition = text( "speedup( " ) + base + ", " + cand + " ) >= " + bound;
+
+    if ( result.low < minimum )
+        throw failure{ location{ file, line }, proposition, speedup_string( result ) };
+
+    if ( output.pass() )
+    {
+        arena_scope scope;
+        report( output.os, passing{ location{ file, line }, proposition, speedup_string( result ), output.zen() }, output.context() );
+    }
+}
+
+// Empirical complexity: time a body over a geometric range of sizes and fit
+// the times to c * g(n) for each complexity class g by least squares of the
+// relative errors, so that each size weighs the same. The class with the
+// smallest root mean square relative error fits best:
+
+// The classes have a namespace of their own, so that their short names don't
+// enter namespace lest, and with it the tests that use it:
+
+namespace complexities {
+
+enum complexity { o1, oLogN, oN, oNLogN, oN2, oN3 };
+
+} // namespace complexities
+
+using complexities::complexity;
+
+inline char const * complexity_name( complexity c )
+{
+    static char const * const names[] = { "O(1)", "O(log n)", "O(n)", "O(n log n)", "O(n^2)", "O(n^3)" };
+    return names[ c ];
+}
+
+inline double complexity_of( complexity c, double n )
+{
+    switch ( c )
+    {
+        case complexities::o1    : return 1;
+        case complexities::oLogN : return std::log2( n );
+        case complexities::oN    : return n;
+        case complexities::oNLogN: return n * std::log2( n );
+        case complexities::oN2   : return n * n;
+        case complexities::oN3   : return n * n * n;
+    }
+    return 1;
+}
+
+// Sizes from first to last, each the previous one times factor, without
+// overflowing the next size:
+
+inline std::vector<std::size_t> sizes( std::size_t first, std::size_t last, std::size_t factor = 2 )
+{
+    const std::size_t times = (std::max)( factor, std::size_t( 2 ) );
+
+    std::vector<std::size_t> result;
+    for ( std::size_t n = (std::max)( first, std::size_t( 1 ) ); n <= last; n *= times )
+    {
+        result.push_back( n );
+
+        if ( n > last / times )
+            break;
+    }
+    return result;
+}
+
+struct complexity_fit
+{
+    complexity best;
+    double rms[ complexities::oN3 + 1 ];  // relative error, per class
+};
+
+inline complexity_fit fit_complexity( std::vector<std::size_t> const & n, std::vector<double> const & seconds )
+{
+    complexity_fit result{ complexities::o1, {} };
+
+    for ( int k = complexities::o1; k <= complexities::oN3; ++k )
+    {
+        const complexity c = static_cast<complexity>( k );
+
+        // minimise sum( ( 1 - coefficient * g / t )^2 ):
+        double r = 0, rr = 0;
+        for ( std::size_t i = 0; i < n.size(); ++i )
+        {
+            const double q = seconds[i] > 0 ? complexity_of( c, static_cast<double>( n[i] ) ) / seconds[i] : 0;
+            r += q; rr += q * q;
+        }
+        const double coefficient = rr > 0 ? r / rr : 0;
+
+        double squares = 0;
+        for ( std::size_t i = 0; i < n.size(); ++i )
+        {
+            const double error = seconds[i] > 0 ? 1 - coefficient * complexity_of( c, static_cast<double>( n[i] ) ) / seconds[i] : 0;
+            squares += error * error;
+        }
+        result.rms[k] = std::sqrt( squares / static_cast<double>( n.size() ) );
+
+        if ( result.rms[k] < result.rms[ result.best ] )
+            result.best = c;
+    }
+    return result;
+}
+
+// Time per call at each size, the least of three batches:
+
+template< typename F >
+std::vector<double> time_over_sizes( F & body, std::vector<std::size_t> const & n, double budget )
+{
+    const double batch = (std::max)( budget / static_cast<double>( 5 * n.size() ), 1e-3 );
+
+    std::vector<double> result;
+    for ( auto size : n )
+    {
+        auto at_size = [&]() { return body( size ); };
+
+        const std::size_t runs = runs_per_batch( at_size, batch );
+
+        double best = seconds_per_run( at_size, runs );
+        for ( int i = 0; i < 2; ++i )
+            best = (std::min)( best, seconds_per_run( at_size, runs ) );
+
+        result.push_back( best );
+    }
+    return result;
+}
+
+inline text complexity_string( complexity_fit const & fit, complexity expected )
+{
+    std::ostringstream os;
+    os << std::setprecision(2) << "best fit " << complexity_name( fit.best ) << ", rms " << 100 * fit.rms[ fit.best ] << "%";
+
+    if ( fit.best != expected )
+        os << "; " << complexity_name( expected ) << ": rms " << 100 * fit.rms[ expected ] << "%";
+
+    return os.str();
+}
+
+// Expect the best fitting class to be no worse than the expected one:
+
+template< typename F >
+void expect_complexity( env & output, F body, std::vector<std::size_t> const & n, complexity expected, char const * file, int line, char const * expr, char const * bound )
+{
+    const text proposition = text( "complexity( " ) + expr + " ) <= " + bound;
+
+    if ( n.size() < 3 )
+        throw failure{ location{ file, line }, proposition, "fewer than 3 sizes" };
+
+    const complexity_fit fit = fit_complexity( n, time_over_sizes( body, n, 1e-3 * output.opt.benchmark ) );
+
+    if ( fit.best > expected )
+        throw failure{ location{ file, line }, proposition, complexity_string( fit, expected ) };
+
+    if ( output.pass() )
+    {
+        arena_scope scope;
+        report( output.os, passing{ location{ file, line }, proposition, complexity_string( fit, expected ), output.zen() }, output.context() );
+    }
+}
+
+// Baselines of benchmarks and of tests timed with option --time: results are
+// saved with option --baseline-save and compared with option --baseline-compare;
+// a test fails if it is slower than its baseline by more than the threshold of
+// option --baseline-threshold and a one-sided Welch t-test at 5% agrees:
+
+inline text compiler();
+
+struct baseline
+{
+    struct entry
+    {
+        statistics stats;
+        int line;
+    };
+
+    std::map< text, entry > known;
+    std::vector< std::pair< text, statistics > > measured;
+    std::map< text, std::vector<double> > repeated;
+    text file;
+#if lest_FEATURE_JOBS
+    std::mutex mutex;
+#endif
+};
+
+inline baseline & baselines()
+{
+    static baseline store;
+    return store;
+}
+
+inline text cpu_model()
+{
+    std::ifstream in( "/proc/cpuinfo" );
+
+    for ( text line; std::getline( in, line ); )
+    {
+        if ( line.compare( 0, 10, "model name" ) == 0 && line.find( ": " ) != text::npos )
+            return line.substr( line.find( ": " ) + 2 );
+    }
+    return "[cpu]";
+}
+
+inline text build_flags()
+{
+#ifdef lest_BUILD_FLAGS
+    return lest_BUILD_FLAGS;
+#else
+    text flags;
+# if defined( __OPTIMIZE__ )
+    flags += "-O";
+# else
+    flags += "-O0";
+# endif
+# if defined( NDEBUG )
+    flags += " -DNDEBUG";
+# endif
+    return flags;
+#endif
+}
+
+inline texts fingerprint()
+{
+    return { "# cpu: " + cpu_model(), "# compiler: " + compiler(), "# flags: " + build_flags() };
+}
+
+inline void load_baseline( text filename, std::ostream & os )
+{
+    std::ifstream in( filename );
+
+    if ( ! in )
+        throw std::runtime_error( "cannot read baseline from '" + filename + "'" );
+
+    baseline & store = baselines();
+    store.known.clear();
+    store.file = filename;
+
+    const texts current = fingerprint();
+    texts differ;
+    int number = 0;
+
+    for ( text line; std::getline( in, line ); )
+    {
+        ++number;
+
+        if ( line.compare( 0, 2, "# " ) == 0 )
+        {
+            for ( auto & item : current )
+            {
+                const auto key = item.substr( 0, item.find( ": " ) + 2 );
+
+                if ( line.compare( 0, key.size(), key ) == 0 && line != item )
+                    differ.push_back( line.substr( 2 ) + " (now: " + item.substr( key.size() ) + ")" );
+            }
+            continue;
+        }
+
+        std::istringstream fields( line );
+        statistics stats;
+        text name;
+
+        if ( fields >> stats.median >> stats.mad >> stats.mean >> stats.sd >> stats.samples && fields.get() == '\t' && std::getline( fields, name ) )
+        {
+            if ( ! name.empty() && name.back() == '\r' )
+                name.pop_back();
+
+            store.known[ name ] = { stats, number };
+        }
+    }
+
+    for ( auto & item : differ )
+        os << "Note: baseline '" << filename << "' is from another environment, " << item << "\n";
+}
+
+inline void save_baseline( text filename )
+{
+    std::ofstream out( filename );
+
+    if ( ! out )
+        throw std::runtime_error( "cannot write baseline to '" + filename + "'" );
+
+    out << "# lest baseline: median, mad, mean, sd in seconds, samples, name\n";
+
+    for ( auto & line : fingerprint() )
+        out << line << "\n";
+
+    out << std::setprecision( 9 );
+
+    for ( auto & item : baselines().measured )
+    {
+        auto & stats = item.second;
+        out << stats.median << "\t" << stats.mad << "\t" << stats.mean << "\t" << stats.sd << "\t" << stats.samples << "\t" << item.first << "\n";
+    }
+}
+
+// Critical value of Student's t distribution for a one-sided test at 5%:
+
+inline double t_critical( double df )
+{
+    static const double table[] =
+    {
+        6.314, 2.920, 2.353, 2.132, 2.015, 1.943, 1.895, 1.860, 1.833, 1.812,
+        1.796, 1.782, 1.771, 1.761, 1.753, 1.746, 1.740, 1.734, 1.729, 1.725,
+        1.721, 1.717, 1.714, 1.711, 1.708, 1.706, 1.703, 1.701, 1.699, 1.697,
+    };
+
+    if ( df < 1 )
+        return std::numeric_limits<double>::infinity();
+
+    if ( df < 30 )
+        return table[ static_cast<std::size_t>( df ) - 1 ];
+
+    return 1.645 + 1.54 / df;
+}
+
+struct comparison
+{
+    double change;    // relative change of the median
+    double t;         // Welch's t of the medians
+    double df;        // its degrees of freedom
+
+    bool significant() const { return std::abs( t ) > t_critical( df ); }
+};
+
+// Compare the medians rather than the means, so that a few samples delayed by
+// other processes don't hide a change: the standard error of a median is taken
+// as 1.2533 sd / sqrt(n), with sd estimated robustly as 1.4826 mad:
+
+inline comparison compare( statistics const & now, statistics const & before )
+{
+    comparison result{ before.median > 0 ? now.median / before.median - 1 : 0, 0, 0 };
+
+    if ( now.samples < 2 || before.samples < 2 )
+        return result;
+
+    const double n1 = static_cast<double>( now.samples    );
+    const double n2 = static_cast<double>( before.samples );
+    const double s1 = 1.2533 * 1.4826 * now.mad;
+    const double s2 = 1.2533 * 1.4826 * before.mad;
+    const double v1 = s1 * s1 / n1;
+    const double v2 = s2 * s2 / n2;
+    const double diff = now.median - before.median;
+
+    if ( v1 + v2 > 0 )
+    {
+        result.t  = diff / std::sqrt( v1 + v2 );
+        result.df = ( v1 + v2 ) * ( v1 + v2 ) / ( v1 * v1 / ( n1 - 1 ) + v2 * v2 / ( n2 - 1 ) );
+    }
+    else
+    {
+        result.t  = diff > 0 ? std::numeric_limits<double>::infinity() : diff < 0 ? -std::numeric_limits<double>::infinity() : 0;
+        result.df = n1 + n2 - 2;
+    }
+    return result;
+}
+
+inline text comparison_string( statistics const & now, statistics const & before, comparison const & cmp )
+{
+    std::ostringstream os;
+    os << "median " << duration_string( now.median ) << " vs " << duration_string( before.median )
+       << std::fixed << std::setprecision( 1 ) << ", " << std::showpos << 100 * cmp.change << std::noshowpos << "%"
+       << std::setprecision( 2 ) << ", t = " << cmp.t << ", df = " << std::setprecision( 1 ) << cmp.df;
+    return os.str();
+}
+
+inline void gauge( test const & testing, statistics const & stats, env & output )
+{
+    if ( stats.samples == 0 || ( output.opt.baseline_save.empty() && output.opt.baseline_compare.empty() ) )
+        return;
+
+    baseline & store = baselines();
+    baseline::entry before{ statistics(), 0 };
+    {
+#if lest_FEATURE_JOBS
+        std::lock_guard<std::mutex> lock( store.mutex );
+#endif
+        if ( ! output.opt.baseline_save.empty() )
+            store.measured.emplace_back( testing.name, stats );
+
+        auto found = store.known.find( testing.name );
+
+        if ( output.opt.baseline_compare.empty() || found == store.known.end() )
+            return;
+
+        before = found->second;
+    }
+
+    const comparison cmp = compare( stats, before.stats );
+    const double threshold = output.opt.threshold / 100.0;
+    const location where{ store.file.c_str(), before.line };
+
+    if ( cmp.change > threshold && cmp.t > 0 && cmp.significant() )
+        output.record( message{ "failed: slower than baseline", where, comparison_string( stats, before.stats, cmp ) } );
+
+    else if ( cmp.change < -threshold && cmp.t < 0 && cmp.significant() )
+        report( output.os, message{ "passed: faster than baseline", where, comparison_string( stats, before.stats, cmp ) }, output.context() );
+
+    else if ( std::abs( cmp.change ) > threshold )
+        report( output.os, message{ cmp.change > 0 ? "passed: not significantly slower than baseline" : "passed: not significantly faster than baseline", where, comparison_string( stats, before.stats, cmp ) }, output.context() );
+
+    else if ( output.pass() )
+        report( output.os, message{ "passed: as fast as baseline", where, comparison_string( stats, before.stats, cmp ) }, output.context() );
+}
+
+// The durations of a test timed with option --time, one per repetition of
+// option --repeat, summarised once the last one is in; meanwhile none:
+
+inline statistics repeated_durations( test const & testing, double seconds, env & output )
+{
+    const int repetitions = output.opt.repeat;
+
+    if ( repetitions < 2 || ( output.opt.baseline_save.empty() && output.opt.baseline_compare.empty() ) )
+        return summarise( { seconds } );
+
+    baseline & store = baselines();
+#if lest_FEATURE_JOBS
+    std::lock_guard<std::mutex> lock( store.mutex );
+#endif
+    auto & sample = store.repeated[ testing.name ];
+    sample.push_back( seconds );
+
+    if ( sample.size() < static_cast<std::size_t>( repetitions ) )
+        return statistics();
+
+    const statistics result = summarise( sample );
+    store.repeated.erase( testing.name );
+    return result;
+}
+
+inline bool passes( test const & testing, env & output )
+{
+    arena_scope scope;
+    std::unique_ptr<allocation_scope> allocated( allocations_counted() && output.pass() ? new allocation_scope() : nullptr );
+    statistics stats;
+    try
+    {
+        stats = enact( testing, output );
+    }
+    catch( message const & e )
+    {
+        report( output.os, e, output.context() ); return false;
+    }
+    if ( allocated )
+        output.os << testing.name << ": " << allocated->counts() << "\n";
+
+    report_heap_profile( output.os, testing.name );
+
+    gauge( testing, stats, output );
+
+    return output.failed == 0;
+}
+
+// Result of a test run elsewhere, buffered for reporting in declaration order:
+
+struct outcome
+{
+    text report;
+    bool failed;
+    std::exception_ptr error;
+};
+
+template< typename Action >
+outcome execute( Action const & perform, test const & testing )
+{
+    std::ostringstream buf;
+    outcome result{ "", false, nullptr };
+    try
+    {
+        result.failed = ! perform.exercise( testing, buf );
+    }
+    catch(...)
+    {
+        result.error = std::current_exception();
+    }
+    result.report = buf.str();
+    return result;
+}
+
+struct times : action
+{
+    env output;
+    int selected = 0;
+    int failures = 0;
+
+    timer total;
+
+    times( std::ostream & out, options option )
+    : action( out ), output( out, option ), total()
+    {
+        os << std::setfill(' ') << std::fixed << std::setprecision( lest_FEATURE_TIME_PRECISION );
+    }
+
+    operator int() { return failures; }
+
+    bool abort() { return output.abort() && failures > 0; }
+
+    times & operator()( test const & testing )
+    {
+        failures += ! timed( testing, output, os );
+        return *this;
+    }
+
+    static bool timed( test const & testing, env & output, std::ostream & out )
+    {
+        std::unique_ptr<counters> events( output.opt.events ? new counters() : nullptr );
+        if ( events ) events->enable();
+
+        timer t;
+        arena_scope scope;
+        std::unique_ptr<allocation_scope> allocated( allocations_counted() ? new allocation_scope() : nullptr );
+        statistics stats;
+        bool passed = true;
+
+        try
+        {
+            stats = enact( testing, output );
+        }
+        catch( message const & )
+        {
+            passed = false;
+        }
+        const double seconds = t.elapsed_seconds();
+        const allocation_counts counts = allocated ? allocated->counts() : allocation_counts{ 0, 0, 0 };
+
+        if ( events ) events->disable();
+
+        report_heap_profile( output.os, testing.name );
+
+        if ( passed && stats.samples == 0 )
+        {
+            stats = repeated_durations( testing, seconds, output );
+        }
+        if ( passed )
+        {
+            gauge( testing, stats, output );
+        }
+        passed = passed && output.failed == 0;
+
+        out << std::setw(3) << ( 1000 * seconds ) << " ms: " << testing.name  << "\n";
+
+        if ( events && events->any() )
+            out << "   events: " << events->summary() << "\n";
+
+        if ( allocated )
+            out << "   " << counts << "\n";
+
+        return passed;
+    }
+
+    bool exercise( test const & testing, std::ostream & out ) const
+    {
+        out.copyfmt( os );
+        env worker( out, output.opt );
+        return timed( testing, worker, out );
+    }
+
+    times & operator()( outcome const & done )
+    {
+        os << done.report; failures += done.failed;
+
+        if ( done.error )
+            std::rethrow_exception( done.error );
+
+        return *this;
+    }
+
+    ~times()
+    {
+        os << "Elapsed time: " << std::setprecision(1) << total.elapsed_seconds() << " s\n";
+    }
+};
+
+struct confirm : action
+{
+    env output;
+    int selected = 0;
+    int failures = 0;
+
+    confirm( std::ostream & out, options option )
+    : action( out ), output( out, option ) {}
+
+    operator int() { return failures; }
+
+    bool abort() { return output.abort() && failures > 0; }
+
+    confirm & operator()( test const & testing )
+    {
+        ++selected; failures += ! passes( testing, output );
+        return *this;
+    }
+
+    bool exercise( test const & testing, std::ostream & out ) const
+    {
+        env worker( out, output.opt );
+        return passes( testing, worker );
+    }
+
+    confirm & operator()( outcome const & done )
+    {
+        ++selected; failures += done.failed; os << done.report;
+
+        if ( done.error )
+            std::rethrow_exception( done.error );
+
+        return *this;
+    }
+
+    ~confirm()
+    {
+        if ( failures > 0 )
+        {
+            os << failures << " out of " << selected << " selected " << pluralise("test", selected) << " " << colourise( "failed.\n" );
+        }
+        else if ( output.pass() )
+        {
+            os << "All " << selected << " selected " << pluralise("test", selected) << " " << colourise( "passed.\n" );
+        }
+    }
+};
+
+template< typename Action >
+bool abort( Action & perform )
+{
+    return perform.abort();
+}
+
+template< typename Action >
+Action && for_test( schedule const & specification, texts in, Action && perform, int n = 1 )
+{
+    const auto selection = select( specification, in );
+
+    for ( int i = 0; indefinite( n ) || i < n; ++i )
+    {
+        for ( auto testing : selection )
+        {
+            if ( abort( perform( *testing ) ) )
+                return std::move( perform );
+        }
+    }
+    return std::move( perform );
+}
+
+#if lest_FEATURE_JOBS
+
+inline bool serial( test const & testing )
+{
+    auto all = tags( testing.name );
+    return std::find( all.begin(), all.end(), "[serial]" ) != all.end();
+}
+
+// Worker threads that take tests in declaration order until exhausted or cancelled:
+
+class pool
+{
+public:
+    template< typename Work >
+    pool( int jobs, Work work )
+    : next( 0 ), cancel( false ), workers()
+    {
+        for ( int k = 0; k < jobs; ++k )
+        {
+            workers.emplace_back( [this, work]
+            {
+                while ( ! cancel && work( next++ ) )
+                    ;
+            });
+        }
+    }
+
+    ~pool()
+    {
+        cancel = true;
+        for ( auto & worker : workers )
+            worker.join();
+    }
+
+    pool( pool const & ) = delete;
+    void operator=( pool const & ) = delete;
+
+private:
+    std::atomic<std::size_t> next;
+    std::atomic<bool> cancel;
+    std::vector<std::thread> workers;
+};
+
+template< typename Action >
+bool for_jobs( std::vector<test const *> const & selection, Action & perform, int jobs )
+{
+    std::vector<outcome> done( selection.size() );
+    std::vector<char>   ready( selection.size(), false );
+    std::mutex mutex;
+    std::condition_variable available;
+
+    pool workers( jobs, [&]( std::size_t i )
+    {
+        if ( i >= selection.size() )
+            return false;
+
+        outcome result = execute( perform, *selection[i] );
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            done[i] = std::move( result ); ready[i] = true;
+        }
+        available.notify_all();
+        return true;
+    });
+
+    for ( std::size_t i = 0; i < selection.size(); ++i )
+    {
+        std::unique_lock<std::mutex> lock( mutex );
+        available.wait( lock, [&]{ return ready[i] != 0; } );
+        outcome result = std::move( done[i] );
+        lock.unlock();
+
+        if ( abort( perform( result ) ) )
+            return true;
+    }
+    return false;
+}
+
+template< typename Action >
+Action && for_test( schedule const & specification, texts in, Action && perform, int n, int jobs )
+{
+    if ( jobs < 2 )
+        return for_test( specification, in, std::forward<Action>( perform ), n );
+
+    std::vector<test const *> parallel, sequential;
+
+    for ( auto testing : select( specification, in ) )
+    {
+        ( serial( *testing ) ? sequential : parallel ).push_back( testing );
+    }
+
+    for ( int i = 0; indefinite( n ) || i < n; ++i )
+    {
+        if ( for_jobs( parallel, perform, jobs ) )
+            return std::move( perform );
+
+        for ( auto testing : sequential )
+        {
+            if ( abort( perform( *testing ) ) )
+                return std::move( perform );
+        }
+    }
+    return std::move( perform );
+}
+
+#endif // lest_FEATURE_JOBS
+
+#if lest_FEATURE_ISOLATE || lest_FEATURE_SERVE
+
+// Output stream on a file descriptor, e.g. a pipe to the parent process:
+
+class fdbuf : public std::streambuf
+{
+public:
+    explicit fdbuf( int fd_ ) : fd( fd_ ) { setp( buffer, buffer + sizeof buffer ); }
+
+    ~fdbuf() { sync(); }
+
+protected:
+    int_type overflow( int_type chr ) override
+    {
+        if ( sync() != 0 )
+            return traits_type::eof();
+
+        if ( ! traits_type::eq_int_type( chr, traits_type::eof() ) )
+        {
+            *pptr() = traits_type::to_char_type( chr ); pbump( 1 );
+        }
+        return traits_type::not_eof( chr );
+    }
+
+    int sync() override
+    {
+        for ( char const * pos = pbase(); pos < pptr(); )
+        {
+            const ssize_t n = ::write( fd, pos, static_cast<std::size_t>( pptr() - pos ) );
+
+            if ( n < 0 && errno != EINTR )
+                return -1;
+
+            pos += (std::max)( n, ssize_t( 0 ) );
+        }
+        setp( buffer, buffer + sizeof buffer );
+        return 0;
+    }
+
+private:
+    int fd;
+    char buffer[ 4096 ];
+};
+
+#endif // lest_FEATURE_ISOLATE || lest_FEATURE_SERVE
+
+#if lest_FEATURE_ISOLATE
+
+inline text drain( int fd )
+{
+    text result;
+    char buffer[ 4096 ];
+
+    for ( ;; )
+    {
+        const ssize_t n = ::read( fd, buffer, sizeof buffer );
+
+        if ( n > 0 )
+            result.append( buffer, static_cast<std::size_t>( n ) );
+        else if ( n == 0 || errno != EINTR )
+            return result;
+    }
+}
+
+inline void set_limit( int resource, rlim_t value )
+{
+    rlimit lim = { value, value };
+    setrlimit( resource, &lim );
+}
+
+// Report a child process that ended other than by reporting the outcome of
+// its test, such as a test that calls exit(); reported: exit status 1 or 2 is
+// that of lest:
+
+inline text terminated( text name, int status, bool reported )
+{
+    std::ostringstream os;
+
+    if ( WIFSIGNALED( status ) )
+        os << name << ": failed: terminated by signal " << WTERMSIG( status ) << " (" << strsignal( WTERMSIG( status ) ) << ")\n";
+    else if ( WIFEXITED( status ) && ( ! reported || WEXITSTATUS( status ) > 2 ) )
+        os << name << ": failed: exited with code " << WEXITSTATUS( status ) << "\n";
+
+    return os.str();
+}
+
+// Run a test in a forked child process, so that a crash only fails that test:
+
+template< typename Action >
+outcome isolated( Action const & perform, test const & testing, options option )
+{
+    int fds[2];
+
+    if ( pipe( fds ) != 0 )
+        throw std::runtime_error( text( "cannot create pipe for option --isolate: " ) + strerror( errno ) );
+
+    std::cout.flush(); std::cerr.flush(); std::fflush( nullptr );
+
+    const pid_t pid = fork();
+
+    if ( pid < 0 )
+        throw std::runtime_error( text( "cannot fork for option --isolate: " ) + strerror( errno ) );
+
+    if ( pid == 0 )
+    {
+        close( fds[0] );
+
+        if ( option.memory > 0 ) { set_limit( RLIMIT_AS , static_cast<rlim_t>( option.memory ) << 20 ); }
+        if ( option.cpu    > 0 ) { set_limit( RLIMIT_CPU, static_cast<rlim_t>( option.cpu    )       ); }
+
+        int status = 0;
+        {
+            fdbuf buf( fds[1] );
+            std::ostream out( &buf );
+
+            try
+            {
+                status = perform.exercise( testing, out ) ? 0 : 1;
+            }
+            catch( std::exception const & e )
+            {
+                out << testing.name << ": failed: got unexpected exception " << with_message( e.what() ) << "\n"; status = 2;
+            }
+            catch(...)
+            {
+                out << testing.name << ": failed: got unexpected exception of unknown type\n"; status = 2;
+            }
+
+            // mark the outcome as reported:
+            out << '\0';
+        }
+        std::cout.flush(); std::cerr.flush(); std::fflush( nullptr );
+        _exit( status );
+    }
+
+    close( fds[1] );
+    text report = drain( fds[0] );
+    close( fds[0] );
+
+    int status = 0;
+    while ( waitpid( pid, &status, 0 ) < 0 && errno == EINTR )
+        ;
+
+    const bool reported = ! report.empty() && report.back() == '\0';
+
+    if ( reported )
+        report.pop_back();
+
+    return outcome{ report + terminated( testing.name, status, reported ), status != 0 || ! reported, nullptr };
+}
+
+#if lest_FEATURE_JOBS
+
+// Queue of test indices in memory shared with the worker processes; per worker
+// the index of the test it runs, so that a crash can be attributed to that test:
+
+class shared_queue
+{
+public:
+    using index = std::size_t;
+
+    static constexpr index idle = static_cast<index>( -1 );
+
+    explicit shared_queue( int workers )
+    : count( 2 + static_cast<std::size_t>( workers ) )
+    , slot( static_cast<std::atomic<index> *>( mmap( nullptr, count * sizeof( std::atomic<index> ), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 ) ) )
+    {
+        if ( static_cast<void *>( slot ) == MAP_FAILED )
+            throw std::runtime_error( text( "cannot map shared memory for option --isolate: " ) + strerror( errno ) );
+
+        for ( std::size_t i = 0; i < count; ++i )
+            new ( &slot[i] ) std::atomic<index>( i < 2 ? 0 : idle );
+    }
+
+    ~shared_queue()
+    {
+        munmap( slot, count * sizeof( std::atomic<index> ) );
+    }
+
+    shared_queue( shared_queue const & ) = delete;
+    void operator=( shared_queue const & ) = delete;
+
+    index claim( int worker )         { return cancelled() ? idle : running( worker ) = slot[0]++; }
+    index claimed() const             { return slot[0]; }
+    void  cancel()                    { slot[1] = 1; }
+    bool  cancelled() const           { return slot[1] != 0; }
+    std::atomic<index> & running( int worker ) { return slot[ 2 + static_cast<std::size_t>( worker ) ]; }
+
+private:
+    std::size_t count;
+    std::atomic<index> * slot;
+};
+
+// Result record of a worker process: header followed by the report text:
+
+struct record
+{
+    std::uint64_t index;
+    std::int32_t  status;
+    std::uint32_t length;
+};
+
+inline void write_all( int fd, char const * data, std::size_t size )
+{
+    while ( size > 0 )
+    {
+        const ssize_t n = ::write( fd, data, size );
+
+        if ( n < 0 && errno != EINTR )
+            return;
+
+        if ( n > 0 ) { data += n; size -= static_cast<std::size_t>( n ); }
+    }
+}
+
+inline void set_cpu_budget( int seconds )
+{
+    rusage usage;
+    rlimit lim;
+
+    if ( getrusage( RUSAGE_SELF, &usage ) != 0 || getrlimit( RLIMIT_CPU, &lim ) != 0 )
+        return;
+
+    const rlim_t used = static_cast<rlim_t>( usage.ru_utime.tv_sec + usage.ru_stime.tv_sec );
+
+    lim.rlim_cur = (std::min)( used + static_cast<rlim_t>( seconds ) + 1, lim.rlim_max );
+    setrlimit( RLIMIT_CPU, &lim );
+}
+
+// Worker process: run tests taken from the queue until it is empty or cancelled:
+
+template< typename Action >
+void serve( Action const & perform, std::vector<test const *> const & selection, shared_queue & queue, int worker, int fd, options option )
+{
+    if ( option.memory > 0 ) { set_limit( RLIMIT_AS , static_cast<rlim_t>( option.memory ) << 20 ); }
+
+    for ( std::size_t i; ( i = queue.claim( worker ) ) < selection.size(); )
+    {
+        if ( option.cpu > 0 ) { set_cpu_budget( option.cpu ); }
+
+        test const & testing = *selection[i];
+        std::ostringstream out;
+        int status = 0;
+
+        try
+        {
+            status = perform.exercise( testing, out ) ? 0 : 1;
+        }
+        catch( std::exception const & e )
+        {
+            out << testing.name << ": failed: got unexpected exception " << with_message( e.what() ) << "\n"; status = 2;
+        }
+        catch(...)
+        {
+            out << testing.name << ": failed: got unexpected exception of unknown type\n"; status = 2;
+        }
+
+        const text report = out.str();
+        const record head = { static_cast<std::uint64_t>( i ), status, static_cast<std::uint32_t>( report.size() ) };
+
+        write_all( fd, reinterpret_cast<char const *>( &head ), sizeof head );
+        write_all( fd, report.data(), report.size() );
+
+        queue.running( worker ) = shared_queue::idle;
+    }
+    std::cout.flush(); std::cerr.flush(); std::fflush( nullptr );
+    _exit( 0 );
+}
+
+// Initialise once, then let pre-forked worker processes run the tests; replace
+// a worker that dies and report the test it was running as failed:
+
+template< typename Action >
+bool for_workers( std::vector<test const *> const & selection, Action & perform, options option )
+{
+    struct worker { pid_t pid; int fd; text input; };
+
+    shared_queue queue( option.jobs );
+    std::vector<worker> workers( static_cast<std::size_t>( option.jobs ), worker{ -1, -1, "" } );
+    std::vector<outcome> done( selection.size() );
+    std::vector<char>   ready( selection.size(), false );
+
+    auto start = [&]( int k )
+    {
+        int fds[2];
+
+        if ( pipe( fds ) != 0 )
+            throw std::runtime_error( text( "cannot create pipe for option --isolate: " ) + strerror( errno ) );
+
+        std::cout.flush(); std::cerr.flush(); std::fflush( nullptr );
+
+        const pid_t pid = fork();
+
+        if ( pid < 0 )
+            throw std::runtime_error( text( "cannot fork for option --isolate: " ) + strerror( errno ) );
+
+        if ( pid == 0 )
+        {
+            close( fds[0] );
+            for ( auto & other : workers )
+                if ( other.fd >= 0 ) close( other.fd );
+
+            serve( perform, selection, queue, k, fds[1], option );
+        }
+
+        close( fds[1] );
+        workers[ static_cast<std::size_t>( k ) ] = worker{ pid, fds[0], "" };
+    };
+
+    auto receive = [&]( worker & from )
+    {
+        while ( from.input.size() >= sizeof( record ) )
+        {
+            record head;
+            std::memcpy( &head, from.input.data(), sizeof head );
+
+            if ( from.input.size() < sizeof head + head.length )
+                return;
+
+            const std::size_t i = static_cast<std::size_t>( head.index );
+
+            if ( i < selection.size() )
+            {
+                done[i] = outcome{ from.input.substr( sizeof head, head.length ), head.status != 0, nullptr }; ready[i] = true;
+            }
+            from.input.erase( 0, sizeof head + head.length );
+        }
+    };
+
+    auto finish = [&]( int k, bool replace )
+    {
+        worker & from = workers[ static_cast<std::size_t>( k ) ];
+
+        close( from.fd ); from.fd = -1;
+
+        int status = 0;
+        while ( waitpid( from.pid, &status, 0 ) < 0 && errno == EINTR )
+            ;
+
+        const std::size_t i = queue.running( k ).exchange( shared_queue::idle );
+
+        if ( i < selection.size() && ! ready[i] )
+        {
+            text report = terminated( selection[i]->name, status, false );
+
+            if ( report.empty() )
+                report = selection[i]->name + ": failed: worker process exited while running test\n";
+
+            done[i] = outcome{ report, true, nullptr }; ready[i] = true;
+        }
+
+        if ( replace && ! queue.cancelled() && queue.claimed() < selection.size() )
+            start( k );
+    };
+
+    auto stop = [&]( bool force )
+    {
+        queue.cancel();
+
+        for ( int k = 0; k < option.jobs; ++k )
+        {
+            if ( workers[ static_cast<std::size_t>( k ) ].fd >= 0 )
+            {
+                if ( force ) { kill( workers[ static_cast<std::size_t>( k ) ].pid, SIGKILL ); }
+                finish( k, false );
+            }
+        }
+    };
+
+    for ( int k = 0; k < option.jobs && static_cast<std::size_t>( k ) < selection.size(); ++k )
+        start( k );
+
+    for ( std::size_t next = 0; next < selection.size(); )
+    {
+        if ( ready[next] )
+        {
+            if ( abort( perform( done[next++] ) ) )
+            {
+                stop( true ); return true;
+            }
+            continue;
+        }
+
+        std::vector<pollfd> fds;
+        std::vector<int>    ids;
+
+        for ( int k = 0; k < option.jobs; ++k )
+        {
+            if ( workers[ static_cast<std::size_t>( k ) ].fd >= 0 )
+            {
+                fds.push_back( pollfd{ workers[ static_cast<std::size_t>( k ) ].fd, POLLIN, 0 } ); ids.push_back( k );
+            }
+        }
+
+        if ( fds.empty() )
+        {
+            done[next] = outcome{ selection[next]->name + ": failed: not run by a worker process\n", true, nullptr }; ready[next] = true;
+            continue;
+        }
+
+        if ( poll( fds.data(), static_cast<nfds_t>( fds.size() ), -1 ) < 0 )
+        {
+            if ( errno == EINTR )
+                continue;
+            stop( true );
+            throw std::runtime_error( text( "cannot poll worker processes for option --isolate: " ) + strerror( errno ) );
+        }
+
+        for ( std::size_t j = 0; j < fds.size(); ++j )
+        {
+            if ( fds[j].revents == 0 )
+                continue;
+
+            worker & from = workers[ static_cast<std::size_t>( ids[j] ) ];
+            char buffer[ 4096 ];
+            const ssize_t n = ::read( from.fd, buffer, sizeof buffer );
+
+            if ( n > 0 )
+            {
+                from.input.append( buffer, static_cast<std::size_t>( n ) ); receive( from );
+            }
+            else if ( n == 0 || errno != EINTR )
+            {
+                receive( from ); finish( ids[j], true );
+            }
+        }
+    }
+    stop( false );
+    return false;
+}
+
+#endif // lest_FEATURE_JOBS
+
+template< typename Action >
+Action && for_isolated( schedule const & specification, texts in, Action && perform, int n, options option )
+{
+#if lest_FEATURE_JOBS
+    if ( option.jobs > 1 )
+    {
+        std::vector<test const *> parallel, sequential;
+
+        for ( auto testing : select( specification, in ) )
+        {
+            ( serial( *testing ) ? sequential : parallel ).push_back( testing );
+        }
+
+        for ( int i = 0; indefinite( n ) || i < n; ++i )
+        {
+            if ( for_workers( parallel, perform, option ) )
+                return std::move( perform );
+
+            for ( auto testing : sequential )
+            {
+                if ( abort( perform( isolated( perform, *testing, option ) ) ) )
+                    return std::move( perform );
+            }
+        }
+        return std::move( perform );
+    }
+#endif
+    const auto selection = select( specification, in );
+
+    for ( int i = 0; indefinite( n ) || i < n; ++i )
+    {
+        for ( auto testing : selection )
+        {
+            if ( abort( perform( isolated( perform, *testing, option ) ) ) )
+                return std::move( perform );
+        }
+    }
+    return std::move( perform );
+}
+
+#endif // lest_FEATURE_ISOLATE
+
+// Sharding: keep the selected tests of one shard, independent of test order:
+
+inline std::uint64_t stable_hash( text const & name )
+{
+    std::uint64_t hash = 14695981039346656037ull;    // FNV-1a
+
+    for ( auto chr : name )
+    {
+        hash = ( hash ^ static_cast<unsigned char>( chr ) ) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Read durations from the output of option --time, lines like "  12 ms: name":
+
+inline std::map<text, double> durations( text filename )
+{
+    std::ifstream in( filename );
 
-    if ( lb == none || rb == none )
-        return result;
+    if ( ! in )
+        throw std::runtime_error( "cannot read durations from '" + filename + "'" );
+
+    std::map<text, double> result;
 
-    result.emplace_back( name.substr( lb, rb - lb + 1 ) );
+    for ( text line; std::getline( in, line ); )
+    {
+        auto pos = line.find( " ms: " );
 
-    return tags( name.substr( rb + 1 ), result );
+        if ( pos != text::npos )
+            result[ line.substr( pos + 5 ) ] = std::strtod( line.c_str(), nullptr );
+    }
+    return result;
 }
 
-struct ptags : action
+// Keep the tests named in a file, one per line, via a hash set; they are
+// selected even if hidden, unless a test specification is given as well:
+
+inline void listed( schedule & specification, texts & in, options option )
 {
-    std::set<text> result;
+    if ( option.names.empty() )
+        return;
 
-    ptags( std::ostream & out ) : action( out ), result() {}
+    std::ifstream is( option.names );
 
-    ptags & operator()( test testing )
-    {
-        for ( auto & tag : tags( testing.name ) )
-            result.insert( tag );
+    if ( ! is )
+        throw std::runtime_error( "cannot read test names from '" + option.names + "'" );
 
-        return *this;
-    }
+    std::unordered_set<text> names;
 
-    ~ptags()
+    for ( text line; std::getline( is, line ); )
     {
-        std::copy( result.begin(), result.end(), std::ostream_iterator<text>( os, "\n" ) );
+        if ( ! line.empty() && line.back() == '\r' )
+            line.pop_back();
+
+        names.insert( line );
     }
-};
 
-struct count : action
-{
-    int n = 0;
+    specification.erase( std::remove_if( specification.begin(), specification.end(),
+        [&]( test const * testing ) { return names.count( testing->name ) == 0; } ), specification.end() );
 
-    count( std::ostream & out ) : action( out ) {}
+    if ( in.empty() )
+        in.push_back( "@" );
+}
 
-    count & operator()( test ) { ++n; return *this; }
+// Tags interned once per run, with a bitset of tag ids for each test:
 
-    ~count()
+class tag_index
+{
+public:
+    explicit tag_index( schedule const & specification )
+    : ids(), words( 0 ), bits()
     {
-        os << n << " selected " << pluralise("test", n) << "\n";
+        std::vector<std::vector<std::size_t>> of( specification.size() );
+
+        for ( std::size_t i = 0; i < specification.size(); ++i )
+        {
+            for ( auto & tag : tags( specification[i]->name ) )
+                of[i].push_back( ids.emplace( tag, ids.size() ).first->second );
+        }
+
+        words = ( ids.size() + 63 ) / 64;
+        bits.assign( specification.size() * words, 0 );
+
+        for ( std::size_t i = 0; i < specification.size(); ++i )
+        {
+            for ( auto tag : of[i] )
+                bits[ i * words + tag / 64 ] |= std::uint64_t( 1 ) << ( tag % 64 );
+        }
     }
-};
 
-struct timer
-{
-    using time = std::chrono::high_resolution_clock;
+    std::size_t size() const { return ids.size(); }
 
-    time::time_point start = time::now();
+    std::size_t id( text const & tag ) const
+    {
+        auto pos = ids.find( tag );
+        return pos != ids.end() ? pos->second : size();
+    }
 
-    double elapsed_seconds() const
+    bool has( std::size_t testing, std::size_t tag ) const
     {
-        return 1e-6 * static_cast<double>( std::chrono::duration_cast< std::chrono::microseconds >( time::now() - start ).count() );
+        return tag < size() && ( bits[ testing * words + tag / 64 ] >> ( tag % 64 ) & 1u ) != 0;
     }
+
+private:
+    std::unordered_map<text, std::size_t> ids;
+    std::size_t words;
+    std::vector<std::uint64_t> bits;
 };
 
-struct times : action
+// Tag expression like "[fast] & ![net] | [smoke]", with ! before & before |
+// and parentheses, compiled to postfix steps on tag ids:
+
+class tag_expression
 {
-    env output;
-    int selected = 0;
-    int failures = 0;
+public:
+    tag_expression( text expression, tag_index const & index_ )
+    : source( expression ), pos( 0 ), index( index_ ), named(), steps(), stack()
+    {
+        disjunction();
+        if ( skip() != '\0' )
+            invalid();
+    }
 
-    timer total;
+    bool operator()( std::size_t testing ) const
+    {
+        stack.clear();
+        for ( auto & at : steps )
+        {
+            switch ( at.op )
+            {
+                case '!': stack.back() = ! stack.back(); break;
+                case '&': { bool r = stack.back() != 0; stack.pop_back(); stack.back() = stack.back() && r; break; }
+                case '|': { bool r = stack.back() != 0; stack.pop_back(); stack.back() = stack.back() || r; break; }
+                default : stack.push_back( index.has( testing, at.tag ) );
+            }
+        }
+        return stack.back() != 0;
+    }
 
-    times( std::ostream & out, options option )
-    : action( out ), output( out, option ), total()
+    bool names( text const & tag ) const
     {
-        os << std::setfill(' ') << std::fixed << std::setprecision( lest_FEATURE_TIME_PRECISION );
+        return std::find( named.begin(), named.end(), tag ) != named.end();
     }
 
-    operator int() { return failures; }
+private:
+    struct step { char op; std::size_t tag; };
 
-    bool abort() { return output.abort() && failures > 0; }
+    char skip()
+    {
+        while ( pos < source.size() && std::isspace( static_cast<unsigned char>( source[pos] ) ) )
+            ++pos;
+
+        return pos < source.size() ? source[pos] : '\0';
+    }
 
-    times & operator()( test testing )
+    void disjunction()
     {
-        timer t;
+        conjunction();
+        while ( skip() == '|' ) { ++pos; conjunction(); steps.push_back( { '|', 0 } ); }
+    }
 
-        try
-        {
-            testing.behaviour( output( testing.name ) );
-        }
-        catch( message const & )
+    void conjunction()
+    {
+        negation();
+        while ( skip() == '&' ) { ++pos; negation(); steps.push_back( { '&', 0 } ); }
+    }
+
+    void negation()
+    {
+        switch ( skip() )
         {
-            ++failures;
+            case '!': ++pos; negation(); steps.push_back( { '!', 0 } ); break;
+            case '(': ++pos; disjunction(); if ( skip() != ')' ) invalid(); ++pos; break;
+            case '[':
+            {
+                auto rb = source.find( ']', pos );
+                if ( rb == text::npos )
+                    invalid();
+
+                named.push_back( source.substr( pos, rb - pos + 1 ) );
+                steps.push_back( { 't', index.id( named.back() ) } );
+                pos = rb + 1;
+                break;
+            }
+            default: invalid();
         }
-
-        os << std::setw(3) << ( 1000 * t.elapsed_seconds() ) << " ms: " << testing.name  << "\n";
-
-        return *this;
     }
 
-    ~times()
+    void invalid() const
     {
-        os << "Elapsed time: " << std::setprecision(1) << total.elapsed_seconds() << " s\n";
+        throw std::runtime_error( "invalid tag expression '" + source + "' at position " + to_string( pos ) + " (try option --help)" );
     }
-};
 
-struct confirm : action
-{
-    env output;
-    int selected = 0;
-    int failures = 0;
+    text source;
+    std::size_t pos;
+    tag_index const & index;
+    texts named;
+    std::vector<step> steps;
+    mutable std::vector<char> stack;
+};
 
-    confirm( std::ostream & out, options option )
-    : action( out ), output( out, option ) {}
+// Keep the tests whose tags satisfy the tag expression; a hidden test only if
+// the expression names the tag that hides it:
 
-    operator int() { return failures; }
+inline void tagged( schedule & specification, texts & in, options option )
+{
+    if ( option.expression.empty() )
+        return;
 
-    bool abort() { return output.abort() && failures > 0; }
+    const tag_index index( specification );
+    const tag_expression satisfied( option.expression, index );
 
-    confirm & operator()( test testing )
+    auto hidden = [&]( test const & testing )
     {
-        try
-        {
-            ++selected; testing.behaviour( output( testing.name ) );
-        }
-        catch( message const & e )
+        for ( auto & tag : tags( testing.name ) )
         {
-            ++failures; report( os, e, output.context() );
+            if ( ( tag == "[hide]" || tag.compare( 0, 2, "[." ) == 0 ) && ! satisfied.names( tag ) )
+                return true;
         }
-        return *this;
-    }
+        return false;
+    };
 
-    ~confirm()
+    schedule selection;
+    for ( std::size_t i = 0; i < specification.size(); ++i )
     {
-        if ( failures > 0 )
-        {
-            os << failures << " out of " << selected << " selected " << pluralise("test", selected) << " " << colourise( "failed.\n" );
-        }
-        else if ( output.pass() )
-        {
-            os << "All " << selected << " selected " << pluralise("test", selected) << " " << colourise( "passed.\n" );
-        }
+        if ( satisfied( i ) && ! hidden( *specification[i] ) )
+            selection.push_back( specification[i] );
     }
-};
+    specification.swap( selection );
 
-template< typename Action >
-bool abort( Action & perform )
+    if ( in.empty() )
+        in.push_back( "@" );
+}
+
+// Pack tests longest first into the shard with least total duration so far:
+
+inline std::vector<int> balance( schedule const & selection, std::map<text, double> const & known, int shards )
 {
-    return perform.abort();
+    double sum = 0;
+    for ( auto & entry : known ) { sum += entry.second; }
+
+    const double guess = known.empty() ? 1.0 : sum / static_cast<double>( known.size() );
+
+    std::vector<double> weight;
+    for ( auto testing : selection )
+    {
+        auto pos = known.find( testing->name );
+        weight.push_back( pos != known.end() ? pos->second : guess );
+    }
+
+    std::vector<std::size_t> order( selection.size() );
+    for ( std::size_t i = 0; i < order.size(); ++i ) { order[i] = i; }
+
+    std::stable_sort( order.begin(), order.end(), [&]( std::size_t a, std::size_t b )
+    {
+        return weight[a] != weight[b] ? weight[a] > weight[b] : selection[a]->name < selection[b]->name;
+    });
+
+    std::vector<double> load( static_cast<std::size_t>( shards ), 0.0 );
+    std::vector<int> result( selection.size() );
+
+    for ( auto i : order )
+    {
+        auto least = std::min_element( load.begin(), load.end() );
+        *least += weight[i];
+        result[i] = static_cast<int>( least - load.begin() );
+    }
+    return result;
 }
 
-template< typename Action >
-Action && for_test( tests specification, texts in, Action && perform, int n = 1 )
+inline void shard( schedule & specification, texts in, options option )
 {
-    for ( int i = 0; indefinite( n ) || i < n; ++i )
+    if ( option.shards < 2 )
+        return;
+
+    const schedule selection = select( specification, in );
+
+    std::vector<int> owner;
+    if ( option.durations.empty() )
     {
-        for ( auto & testing : specification )
-        {
-            if ( select( testing.name, in ) )
-                if ( abort( perform( testing ) ) )
-                    return std::move( perform );
-        }
+        for ( auto testing : selection )
+            owner.push_back( static_cast<int>( stable_hash( testing->name ) % static_cast<std::uint64_t>( option.shards ) ) );
+    }
+    else
+    {
+        owner = balance( selection, durations( option.durations ), option.shards );
+    }
+
+    specification.clear();
+    for ( std::size_t i = 0; i < selection.size(); ++i )
+    {
+        if ( owner[i] == option.shard )
+            specification.push_back( selection[i] );
     }
-    return std::move( perform );
 }
 
-inline void sort( tests & specification )
+inline void sort( schedule & specification )
 {
-    auto test_less = []( test const & a, test const & b ) { return a.name < b.name; };
+    auto test_less = []( test const * a, test const * b ) { return a->name < b->name; };
     std::sort( specification.begin(), specification.end(), test_less );
 }
 
-inline void shuffle( tests & specification, options option )
+inline void shuffle( schedule & specification, options option )
 {
     std::shuffle( specification.begin(), specification.end(), std::mt19937( option.seed ) );
 }
@@ -1343,6 +5374,50 @@ inline int repeat( text opt, text arg )
     throw std::runtime_error( "expecting '-1' or positive number with option '" + opt + "', got '" + arg + "' (try option --help)" );
 }
 
+inline int jobs( text opt, text arg )
+{
+    const int num = lest::stoi( arg );
+
+    if ( is_number( arg ) && num > 0 )
+        return num;
+
+    throw std::runtime_error( "expecting positive number with option '" + opt + "', got '" + arg + "' (try option --help)" );
+}
+
+inline int limit( text opt, text arg )
+{
+    const int num = lest::stoi( arg );
+
+    if ( is_number( arg ) && num >= 0 )
+        return num;
+
+    throw std::runtime_error( "expecting non-negative number with option '" + opt + "', got '" + arg + "' (try option --help)" );
+}
+
+inline text path( text opt, text arg )
+{
+    if ( ! arg.empty() )
+        return arg;
+
+    throw std::runtime_error( "expecting path with option '" + opt + "' (try option --help)" );
+}
+
+inline std::pair<int, int> shard( text opt, text arg )
+{
+    auto pos = arg.find( '/' );
+
+    if ( pos != text::npos && is_number( arg.substr( 0, pos ) ) && is_number( arg.substr( pos + 1 ) ) )
+    {
+        const int index = lest::stoi( arg.substr( 0, pos ) );
+        const int count = lest::stoi( arg.substr( pos + 1 ) );
+
+        if ( pos > 0 && index < count )
+            return std::make_pair( index, count );
+    }
+
+    throw std::runtime_error( "expecting index/count with 0 <= index < count with option '" + opt + "', got '" + arg + "' (try option --help)" );
+}
+
 inline auto split_option( text arg ) -> std::tuple<text, text>
 {
     auto pos = arg.rfind( '=' );
@@ -1382,6 +5457,35 @@ inline auto split_arguments( texts args ) -> std::tuple<options, texts>
             else if ( opt == "--order" && "random"       == val ) { option.random  =  true; continue; }
             else if ( opt == "--random-seed" ) { option.seed   = seed  ( "--random-seed", val ); continue; }
             else if ( opt == "--repeat"      ) { option.repeat = repeat( "--repeat"     , val ); continue; }
+            else if ( opt == "--max-print"   ) { option.print  = limit ( "--max-print"  , val ); continue; }
+            else if ( opt == "--benchmark-time" ) { option.benchmark = limit( "--benchmark-time", val ); continue; }
+            else if ( opt == "--baseline-save"      ) { option.baseline_save    = path ( "--baseline-save"     , val ); continue; }
+            else if ( opt == "--baseline-compare"   ) { option.baseline_compare = path ( "--baseline-compare"  , val ); continue; }
+            else if ( opt == "--baseline-threshold" ) { option.threshold        = limit( "--baseline-threshold", val ); continue; }
+            else if ( opt == "--shard"       ) { std::tie( option.shard, option.shards ) = shard( "--shard", val ); continue; }
+            else if ( opt == "--shard-times" ) { option.durations = val; continue; }
+            else if ( opt == "--tests-from"  ) { option.names  = path  ( "--tests-from" , val ); continue; }
+            else if ( opt == "--tags"        ) { option.expression = val; continue; }
+            else if ( opt == "--format" && "text"        == val ) { option.json    = false; continue; }
+            else if ( opt == "--format" && "json"        == val ) { option.json    =  true; continue; }
+#if lest_FEATURE_JOBS
+            else if ( opt == "--jobs"        ) { option.jobs   = jobs  ( "--jobs"       , val ); continue; }
+#endif
+#if lest_FEATURE_ISOLATE
+            else if (                     "--isolate"    == opt ) { option.isolate =  true; continue; }
+            else if ( opt == "--limit-memory" ) { option.memory = limit( "--limit-memory", val ); continue; }
+            else if ( opt == "--limit-cpu"    ) { option.cpu    = limit( "--limit-cpu"   , val ); continue; }
+#endif
+#if lest_FEATURE_SERVE
+            else if ( opt == "--serve"       ) { option.socket = path  ( "--serve"      , val ); continue; }
+#endif
+#if lest__perf_counters
+            else if (                     "--counters"   == opt ) { option.events  =  true; continue; }
+#endif
+#if lest__heap_profile
+            else if ( opt == "--heap-profile" ) { option.heap_profile = path( "--heap-profile", val ); continue; }
+            else if ( opt == "--heap-sample"  ) { option.heap_sample  = jobs( "--heap-sample" , val ); continue; }
+#endif
             else throw std::runtime_error( "unrecognised option '" + arg + "' (try option --help)" );
         }
         in.push_back( arg );
@@ -1400,7 +5504,7 @@ inline int usage( std::ostream & os )
         "  -h, --help         this help message\n"
         "  -a, --abort        abort at first failure\n"
         "  -c, --count        count selected tests\n"
-        "  -g, --list-tags    list tags of selected tests\n"
+        "  -g, --list-tags    list tags of selected tests, with number of tests\n"
         "  -l, --list-tests   list selected tests\n"
         "  -p, --pass         also report passing tests\n"
         "  -z, --pass-zen     ... without expansion\n"
@@ -1412,6 +5516,34 @@ inline int usage( std::ostream & os )
         "  --random-seed=n    use n for random generator seed\n"
         "  --random-seed=time use time for random generator seed\n"
         "  --repeat=n         repeat selected tests n times (-1: indefinite)\n"
+        "  --max-print=n      print at most n elements of a container (0: all)\n"
+        "  --benchmark-time=n run each selected benchmark for about n ms (1000)\n"
+        "  --baseline-save=file    save times of benchmarks and of option --time\n"
+        "  --baseline-compare=file ... fail tests significantly slower than saved\n"
+        "  --baseline-threshold=n  ... by more than n percent (5)\n"
+        "  --shard=i/n        run shard i of n (0 <= i < n) of the selected tests\n"
+        "  --shard-times=file ... balanced by durations from option --time\n"
+        "  --tests-from=file  select the tests named in file, one per line\n"
+        "  --tags=expression  select tests by tags, e.g. \"[a] & ![b] | ([c])\"\n"
+        "  --format=json      list tests with option --list-tests as JSON\n"
+#if lest_FEATURE_JOBS
+        "  --jobs=n           run selected tests on n threads, [serial] ones after\n"
+#endif
+#if lest_FEATURE_ISOLATE
+        "  --isolate          run each selected test in a child process\n"
+        "  --limit-memory=n   ... limiting its address space to n MiB\n"
+        "  --limit-cpu=n      ... limiting its processor time to n seconds\n"
+#endif
+#if lest_FEATURE_SERVE
+        "  --serve=socket     stay resident, run tests requested via Unix socket\n"
+#endif
+#if lest__perf_counters
+        "  --counters         count instructions, cycles etc. of --time and benchmarks\n"
+#endif
+#if lest__heap_profile
+        "  --heap-profile=file sample allocations of tests, save folded stacks to file\n"
+        "  --heap-sample=n    ... one per n bytes allocated on average (4096)\n"
+#endif
         "  --version          report lest version and compiler used\n"
         "  --                 end options\n"
         "\n"
@@ -1452,24 +5584,186 @@ inline int version( std::ostream & os )
     return 0;
 }
 
-inline int run( tests specification, texts arguments, std::ostream & os = std::cout )
+#if lest_FEATURE_SERVE
+
+// Test server: stay resident and run the tests requested over a Unix domain socket.
+// Request: one argument per line, ended by an empty line. Reply: the report, a NUL
+// character and the exit status. Request --serve-stop ends the server.
+
+inline int dispatch( schedule specification, texts arguments, std::ostream & os );
+
+inline bool receive( int fd, texts & arguments )
+{
+    text line;
+
+    for ( char chr; ; )
+    {
+        const ssize_t n = ::read( fd, &chr, 1 );
+
+        if ( n < 0 && errno == EINTR )
+            continue;
+
+        if ( n <= 0 )
+            return false;
+
+        if ( chr != '\n' )
+        {
+            line += chr;
+        }
+        else if ( line.empty() )
+        {
+            return true;
+        }
+        else
+        {
+            arguments.push_back( line ); line.clear();
+        }
+    }
+}
+
+inline int serve( schedule const & specification, text path )
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+
+    if ( path.size() >= sizeof address.sun_path )
+        throw std::runtime_error( "socket path too long for option --serve" );
+
+    std::memcpy( address.sun_path, path.c_str(), path.size() );
+
+    const int server = socket( AF_UNIX, SOCK_STREAM, 0 );
+
+    if ( server < 0 )
+        throw std::runtime_error( text( "cannot create socket for option --serve: " ) + strerror( errno ) );
+
+    unlink( path.c_str() );
+
+    if ( bind( server, reinterpret_cast<sockaddr const *>( &address ), sizeof address ) != 0 || listen( server, 8 ) != 0 )
+    {
+        const text reason = strerror( errno );
+        close( server );
+        throw std::runtime_error( "cannot listen on '" + path + "' for option --serve: " + reason );
+    }
+
+    std::signal( SIGPIPE, SIG_IGN );
+
+    for ( bool serving = true; serving; )
+    {
+        const int client = accept( server, nullptr, nullptr );
+
+        if ( client < 0 )
+        {
+            if ( errno == EINTR )
+                continue;
+            break;
+        }
+
+        texts arguments;
+
+        if ( receive( client, arguments ) )
+        {
+            fdbuf buf( client );
+            std::ostream out( &buf );
+
+            serving = !( arguments.size() == 1 && arguments[0] == "--serve-stop" );
+
+            const bool nested = std::any_of( arguments.begin(), arguments.end(), []( text const & arg ) { return arg.compare( 0, 7, "--serve" ) == 0; } );
+
+            int status = 0;
+
+            if ( nested && serving )
+            {
+                out << "Error: option --serve cannot be requested from a test server\n"; status = 1;
+            }
+            else if ( serving )
+            {
+                status = dispatch( specification, arguments, out );
+            }
+
+            out << '\0' << status << std::flush;
+        }
+        close( client );
+    }
+    close( server );
+    unlink( path.c_str() );
+    return 0;
+}
+
+#endif // lest_FEATURE_SERVE
+
+// Run the selected tests, reporting failures or durations:
+
+inline int perform( schedule const & specification, texts const & in, options const & option, std::ostream & os )
+{
+    if ( ! option.heap_profile.empty() )
+    {
+        if ( ! allocations_counted() )
+            throw std::runtime_error( "option --heap-profile requires lest/lest_alloc.hpp" );
+
+        if ( option.isolate || option.jobs > 1 )
+            throw std::runtime_error( "option --heap-profile cannot be combined with --isolate or --jobs" );
+    }
+
+    // counts are global, a test's would include those of the tests beside it:
+
+    if ( allocations_counted() && option.jobs > 1 && ! option.isolate )
+        throw std::runtime_error( "option --jobs requires --isolate with lest/lest_alloc.hpp" );
+
+#if lest_FEATURE_ISOLATE
+    if ( option.isolate )
+    {
+        if ( ! option.baseline_save.empty() )
+            throw std::runtime_error( "option --baseline-save cannot be combined with --isolate" );
+
+        if ( option.time ) { return for_isolated( specification, in, times( os, option ), 1, option ); }
+
+        return for_isolated( specification, in, confirm( os, option ), option.repeat, option );
+    }
+#endif
+#if lest_FEATURE_JOBS
+    if ( option.time    ) { return for_test( specification, in, times( os, option ), option.repeat, option.jobs ); }
+
+    return for_test( specification, in, confirm( os, option ), option.repeat, option.jobs );
+#else
+    if ( option.time    ) { return for_test( specification, in, times( os, option ), option.repeat ); }
+
+    return for_test( specification, in, confirm( os, option ), option.repeat );
+#endif
+}
+
+inline int dispatch( schedule specification, texts arguments, std::ostream & os )
 {
     try
     {
         options option; texts in;
         std::tie( option, in ) = split_arguments( arguments );
 
+#if lest_FEATURE_SERVE
+        if ( ! option.socket.empty() ) { return serve( specification, option.socket ); }
+#endif
+        listed( specification, in, option );
+        tagged( specification, in, option );
+        shard ( specification, in, option );
+
         if ( option.lexical ) {    sort( specification         ); }
         if ( option.random  ) { shuffle( specification, option ); }
 
         if ( option.help    ) { return usage   ( os ); }
         if ( option.version ) { return version ( os ); }
         if ( option.count   ) { return for_test( specification, in, count( os ) ); }
-        if ( option.list    ) { return for_test( specification, in, print( os ) ); }
+        if ( option.list    ) { return for_test( specification, in, print( os, option.json ) ); }
         if ( option.tags    ) { return for_test( specification, in, ptags( os ) ); }
-        if ( option.time    ) { return for_test( specification, in, times( os, option ) ); }
 
-        return for_test( specification, in, confirm( os, option ), option.repeat );
+        if ( ! option.baseline_compare.empty() ) { load_baseline( option.baseline_compare, os ); }
+
+        baselines().measured.clear();
+
+        const int failures = perform( specification, in, option, os );
+
+        if ( ! option.baseline_save.empty() ) { save_baseline( option.baseline_save ); }
+        if ( ! option.heap_profile.empty()  ) { save_heap_profile( option.heap_profile ); }
+
+        return failures;
     }
     catch ( std::exception const & e )
     {
@@ -1478,28 +5772,47 @@ inline int run( tests specification, texts arguments, std::ostream & os = std::c
     }
 }
 
-inline int run( tests specification, int argc, char * argv[], std::ostream & os = std::cout )
+template< typename Iter >
+schedule refer( Iter first, Iter last, schedule result = {} )
+{
+    for ( ; first != last; ++first )
+        result.push_back( &*first );
+
+    return result;
+}
+
+inline int run( tests const & specification, texts arguments, std::ostream & os = std::cout )
+{
+    return dispatch( refer( specification.begin(), specification.end() ), arguments, os );
+}
+
+inline int run( tests const & specification, int argc, char * argv[], std::ostream & os = std::cout )
 {
+#if lest__linker_register
+    tests const & registry = registered();
+    return dispatch( refer( registry.begin(), registry.end(), refer( specification.begin(), specification.end() ) ), texts( argv + 1, argv + argc ), os );
+#else
     return run( specification, texts( argv + 1, argv + argc ), os  );
+#endif
 }
 
 template< std::size_t N >
 int run( test const (&specification)[N], texts arguments, std::ostream & os = std::cout )
 {
     std::cout.sync_with_stdio( false );
-    return (std::min)( run( tests( specification, specification + N ), arguments, os  ), exit_max_value );
+    return (std::min)( dispatch( refer( specification, specification + N ), arguments, os  ), exit_max_value );
 }
 
 template< std::size_t N >
 int run( test const (&specification)[N], std::ostream & os = std::cout )
 {
-    return run( tests( specification, specification + N ), {}, os  );
+    return dispatch( refer( specification, specification + N ), {}, os  );
 }
 
 template< std::size_t N >
 int run( test const (&specification)[N], int argc, char * argv[], std::ostream & os = std::cout )
 {
-    return run( tests( specification, specification + N ), texts( argv + 1, argv + argc ), os  );
+    return dispatch( refer( specification, specification + N ), texts( argv + 1, argv + argc ), os  );
 }
 
 } // namespace lest
@@ -0,0 +1,120 @@
+// Copyright 2026 by Martin Moene
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Allocation accounting for lest: replaces the global operator new and delete
+// to count allocations per test. Include in exactly one translation unit of
+// the test program, e.g. the one with main().
+
+#ifndef LEST_LEST_ALLOC_HPP_INCLUDED
+#define LEST_LEST_ALLOC_HPP_INCLUDED
+
+#include "lest/lest.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace lest {
+
+// The size of a block and its offset from the allocated memory are kept in
+// front of it, the offset marked if the heap profiler sampled the block;
+// blocks that must be aligned more strictly than malloc() does get the slack
+// to shift them. The operators pass their return address down, for the heap
+// profiler to find the allocating function in the stack:
+
+const std::size_t sampled_mark = ~( ~std::size_t( 0 ) >> 1 );
+
+lest_NOINLINE inline void * counted_allocate( std::size_t size, std::size_t alignment, void const * caller )
+{
+    const std::size_t header = (std::max)( alignment, (std::max)( alignof( std::max_align_t ), 2 * sizeof( std::size_t ) ) );
+    const std::size_t slack  = header - alignof( std::max_align_t );
+
+    char * memory = static_cast<char *>( std::malloc( header + slack + size ) );
+
+    if ( ! memory )
+        return nullptr;
+
+    const std::uintptr_t address = ( reinterpret_cast<std::uintptr_t>( memory ) + header ) & ~std::uintptr_t( header - 1 );
+    std::size_t * result = reinterpret_cast<std::size_t *>( address );
+
+    result[ -1 ] = size;
+    result[ -2 ] = static_cast<std::size_t>( reinterpret_cast<char *>( result ) - memory );
+
+    count_allocation( size );
+
+    if ( sample_allocation( result, size, caller ) )
+        result[ -2 ] |= sampled_mark;
+
+    return result;
+}
+
+inline void counted_free( void * ptr )
+{
+    if ( ! ptr )
+        return;
+
+    std::size_t * block = static_cast<std::size_t *>( ptr );
+
+    if ( block[ -2 ] & sampled_mark )
+        forget_allocation( ptr );
+
+    count_deallocation( block[ -1 ] );
+    std::free( static_cast<char *>( ptr ) - ( block[ -2 ] & ~sampled_mark ) );
+}
+
+lest_NOINLINE inline void * counted_new( std::size_t size, std::size_t alignment, void const * caller )
+{
+    for (;;)
+    {
+        if ( void * ptr = counted_allocate( size, alignment, caller ) )
+            return ptr;
+
+        if ( std::new_handler handler = std::get_new_handler() )
+            handler();
+        else
+            throw std::bad_alloc();
+    }
+}
+
+static const bool allocations_installed = ( allocation_counters().installed = true );
+
+} // namespace lest
+
+lest_NOINLINE void * operator new  ( std::size_t size ) { return lest::counted_new( size, alignof( std::max_align_t ), lest_RETURN_ADDRESS() ); }
+lest_NOINLINE void * operator new[]( std::size_t size ) { return lest::counted_new( size, alignof( std::max_align_t ), lest_RETURN_ADDRESS() ); }
+
+lest_NOINLINE void * operator new  ( std::size_t size, std::nothrow_t const & ) noexcept { return lest::counted_allocate( size, alignof( std::max_align_t ), lest_RETURN_ADDRESS() ); }
+lest_NOINLINE void * operator new[]( std::size_t size, std::nothrow_t const & ) noexcept { return lest::counted_allocate( size, alignof( std::max_align_t ), lest_RETURN_ADDRESS() ); }
+
+void operator delete  ( void * ptr ) noexcept { lest::counted_free( ptr ); }
+void operator delete[]( void * ptr ) noexcept { lest::counted_free( ptr ); }
+
+void operator delete  ( void * ptr, std::nothrow_t const & ) noexcept { lest::counted_free( ptr ); }
+void operator delete[]( void * ptr, std::nothrow_t const & ) noexcept { lest::counted_free( ptr ); }
+
+#if defined( __cpp_sized_deallocation ) || ( defined( _MSC_VER ) && _MSC_VER >= 1900 )
+void operator delete  ( void * ptr, std::size_t ) noexcept { lest::counted_free( ptr ); }
+void operator delete[]( void * ptr, std::size_t ) noexcept { lest::counted_free( ptr ); }
+#endif
+
+#ifdef __cpp_aligned_new
+lest_NOINLINE void * operator new  ( std::size_t size, std::align_val_t alignment ) { return lest::counted_new( size, static_cast<std::size_t>( alignment ), lest_RETURN_ADDRESS() ); }
+lest_NOINLINE void * operator new[]( std::size_t size, std::align_val_t alignment ) { return lest::counted_new( size, static_cast<std::size_t>( alignment ), lest_RETURN_ADDRESS() ); }
+
+lest_NOINLINE void * operator new  ( std::size_t size, std::align_val_t alignment, std::nothrow_t const & ) noexcept { return lest::counted_allocate( size, static_cast<std::size_t>( alignment ), lest_RETURN_ADDRESS() ); }
+lest_NOINLINE void * operator new[]( std::size_t size, std::align_val_t alignment, std::nothrow_t const & ) noexcept { return lest::counted_allocate( size, static_cast<std::size_t>( alignment ), lest_RETURN_ADDRESS() ); }
+
+void operator delete  ( void * ptr, std::align_val_t ) noexcept { lest::counted_free( ptr ); }
+void operator delete[]( void * ptr, std::align_val_t ) noexcept { lest::counted_free( ptr ); }
+
+void operator delete  ( void * ptr, std::align_val_t, std::nothrow_t const & ) noexcept { lest::counted_free( ptr ); }
+void operator delete[]( void * ptr, std::align_val_t, std::nothrow_t const & ) noexcept { lest::counted_free( ptr ); }
+
+void operator delete  ( void * ptr, std::size_t, std::align_val_t ) noexcept { lest::counted_free( ptr ); }
+void operator delete[]( void * ptr, std::size_t, std::align_val_t ) noexcept { lest::counted_free( ptr ); }
+#endif
+
+#endif // LEST_LEST_ALLOC_HPP_INCLUDED
@@ -14,6 +14,7 @@
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <set>
@@ -385,12 +386,7 @@ namespace lest
     do { \
         lest_TRY \
         { \
-            lest_SUPPRESS_CONTROLLING_EXPRESSION_IS_CONSTANT \
-            if ( lest::result score = lest_DECOMPOSE( expr ) ) \
-                lest_THROW( lest::failure( lest_LOCATION, #expr, score.decomposition ) ); \
-            else if ( lest_env.pass() ) \
-                lest::report( lest_env.os, lest::passing( lest_LOCATION, #expr, score.decomposition, lest_env.zen() ), lest_env.context() ); \
-            lest_RESTORE_CONTROLLING_EXPRESSION_IS_CONSTANT \
+            lest::expect( lest_env, lest_DECOMPOSE( expr ), __FILE__, __LINE__, #expr ); \
         } \
         lest_CATCH_ALL \
         { \
@@ -402,15 +398,7 @@ namespace lest
     do { \
         lest_TRY \
         { \
-            lest_SUPPRESS_CONTROLLING_EXPRESSION_IS_CONSTANT \
-            if ( lest::result score = lest_DECOMPOSE( expr ) ) \
-            { \
-                if ( lest_env.pass() ) \
-                    lest::report( lest_env.os, lest::passing( lest_LOCATION, lest::not_expr( #expr ), lest::not_expr( score.decomposition ), lest_env.zen() ), lest_env.context() ); \
-            } \
-            else \
-                lest_THROW( lest::failure( lest_LOCATION, lest::not_expr( #expr ), lest::not_expr( score.decomposition ) ) ); \
-            lest_RESTORE_CONTROLLING_EXPRESSION_IS_CONSTANT \
+            lest::expect_not( lest_env, lest_DECOMPOSE( expr ), __FILE__, __LINE__, #expr ); \
         } \
         lest_CATCH_ALL \
         { \
@@ -516,14 +504,24 @@ struct add_test
     }
 };
 
+// Outcome of an assertion; the decomposition refers to the operands and is
+// only formatted when it is reported, within the full expression of the assertion:
+
 struct result
 {
+    typedef text (*formatter)( void const * lhs, char const * op, void const * rhs );
+
     const bool passed;
-    const text decomposition;
+    void const * const lhs;
+    char const * const op;
+    void const * const rhs;
+    const formatter format;
 
     template< typename T >
-    result( T const & passed_, text decomposition_)
-    : passed( !!passed_), decomposition( decomposition_) {}
+    result( T const & passed_, void const * lhs_, char const * op_, void const * rhs_, formatter format_)
+    : passed( !!passed_), lhs( lhs_), op( op_), rhs( rhs_), format( format_) {}
+
+    text decomposition() const { return format( lhs, op, rhs ); }
 
     operator bool() { return ! passed; }
 };
@@ -863,21 +861,54 @@ std::string to_string( L const & lhs, std::string op, R const & rhs )
     std::ostringstream os; os << to_string( lhs ) << " " << op << " " << to_string( rhs ); return os.str();
 }
 
+template< typename T > struct remove_reference       { typedef T type; };
+template< typename T > struct remove_reference<T &>  { typedef T type; };
+
+template< typename T >
+void const * address_of( T const & object )
+{
+#if lest_CPP11_OR_GREATER
+    return std::addressof( object );
+#else
+    return &object;
+#endif
+}
+
+template< typename L >
+text format_operand( void const * lhs, char const *, void const * )
+{
+    return to_string( *static_cast<L const *>( lhs ) );
+}
+
+template< typename L, typename R >
+text format_operands( void const * lhs, char const * op, void const * rhs )
+{
+    return to_string( *static_cast<L const *>( lhs ), op, *static_cast<R const *>( rhs ) );
+}
+
 template< typename L >
 struct expression_lhs
 {
+    typedef typename remove_reference<L>::type operand;
+
     L lhs;
 
     expression_lhs( L lhs_) : lhs( lhs_) {}
 
-    operator result() { return result( !!lhs, to_string( lhs ) ); }
+    operator result() { return result( !!lhs, address_of( lhs ), "", lest_nullptr, &format_operand<operand> ); }
 
-    template< typename R > result operator==( R const & rhs ) { return result( lhs == rhs, to_string( lhs, "==", rhs ) ); }
-    template< typename R > result operator!=( R const & rhs ) { return result( lhs != rhs, to_string( lhs, "!=", rhs ) ); }
-    template< typename R > result operator< ( R const & rhs ) { return result( lhs <  rhs, to_string( lhs, "<" , rhs ) ); }
-    template< typename R > result operator<=( R const & rhs ) { return result( lhs <= rhs, to_string( lhs, "<=", rhs ) ); }
-    template< typename R > result operator> ( R const & rhs ) { return result( lhs >  rhs, to_string( lhs, ">" , rhs ) ); }
-    template< typename R > result operator>=( R const & rhs ) { return result( lhs >= rhs, to_string( lhs, ">=", rhs ) ); }
+    template< typename R > result operator==( R const & rhs ) { return decompose( lhs == rhs, "==", rhs ); }
+    template< typename R > result operator!=( R const & rhs ) { return decompose( lhs != rhs, "!=", rhs ); }
+    template< typename R > result operator< ( R const & rhs ) { return decompose( lhs <  rhs, "<" , rhs ); }
+    template< typename R > result operator<=( R const & rhs ) { return decompose( lhs <= rhs, "<=", rhs ); }
+    template< typename R > result operator> ( R const & rhs ) { return decompose( lhs >  rhs, ">" , rhs ); }
+    template< typename R > result operator>=( R const & rhs ) { return decompose( lhs >= rhs, ">=", rhs ); }
+
+    template< typename T, typename R >
+    result decompose( T const & passed, char const * op, R const & rhs )
+    {
+        return result( passed, address_of( lhs ), op, address_of( rhs ), &format_operands<operand, R> );
+    }
 };
 
 struct expression_decomposer
@@ -1109,6 +1140,26 @@ struct env
     }
 };
 
+// Handle the outcome of an assertion, formatting its decomposition only if reported:
+
+inline void expect( env & output, result const & score, char const * file, int line, char const * expr )
+{
+    if ( ! score.passed )
+        lest_THROW( failure( location( file, line ), expr, score.decomposition() ) );
+
+    if ( output.pass() )
+        report( output.os, passing( location( file, line ), expr, output.zen() ? "" : score.decomposition(), output.zen() ), output.context() );
+}
+
+inline void expect_not( env & output, result const & score, char const * file, int line, char const * expr )
+{
+    if ( score.passed )
+        lest_THROW( failure( location( file, line ), not_expr( expr ), not_expr( score.decomposition() ) ) );
+
+    if ( output.pass() )
+        report( output.os, passing( location( file, line ), not_expr( expr ), output.zen() ? "" : not_expr( score.decomposition() ), output.zen() ), output.context() );
+}
+
 struct ctx
 {
     env & environment;
@@ -14,6 +14,7 @@
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -75,8 +76,7 @@
     do { \
         try \
         { \
-            if ( lest::result failed = lest_DECOMPOSE( expr ) ) \
-                throw lest::failure{ lest_LOCATION, #expr, failed.decomposition }; \
+            lest::expect( lest_DECOMPOSE( expr ), __FILE__, __LINE__, #expr ); \
         } \
         catch(...) \
         { \
@@ -128,10 +128,20 @@ struct test
     const std::function<void()> behaviour;
 };
 
+// Outcome of an assertion; the decomposition refers to the operands and is
+// only formatted on failure, within the full expression of the assertion:
+
 struct result
 {
+    using formatter = text (*)( void const * lhs, char const * op, void const * rhs );
+
     const bool passed;
-    const text decomposition;
+    void const * const lhs;
+    char const * const op;
+    void const * const rhs;
+    const formatter format;
+
+    text decomposition() const { return format( lhs, op, rhs ); }
 
     explicit operator bool() { return ! passed; }
 };
@@ -344,21 +354,41 @@ inline std::string to_string( L const & lhs, std::string op, R const & rhs )
     std::ostringstream os; os << to_string( lhs ) << " " << op << " " << to_string( rhs ); return os.str();
 }
 
+template< typename L >
+inline text format_operand( void const * lhs, char const *, void const * )
+{
+    return to_string( *static_cast<L const *>( lhs ) );
+}
+
+template< typename L, typename R >
+inline text format_operands( void const * lhs, char const * op, void const * rhs )
+{
+    return to_string( *static_cast<L const *>( lhs ), op, *static_cast<R const *>( rhs ) );
+}
+
 template< typename L >
 struct expression_lhs
 {
+    using operand = typename std::remove_reference<L>::type;
+
     const L lhs;
 
     expression_lhs( L lhs_) : lhs( lhs_) {}
 
-    operator result() { return result{ !!lhs, to_string( lhs ) }; }
+    operator result() { return result{ !!lhs, std::addressof( lhs ), "", nullptr, format_operand<operand> }; }
 
-    template< typename R > result operator==( R const & rhs ) { return result{ lhs == rhs, to_string( lhs, "==", rhs ) }; }
-    template< typename R > result operator!=( R const & rhs ) { return result{ lhs != rhs, to_string( lhs, "!=", rhs ) }; }
-    template< typename R > result operator< ( R const & rhs ) { return result{ lhs <  rhs, to_string( lhs, "<" , rhs ) }; }
-    template< typename R > result operator<=( R const & rhs ) { return result{ lhs <= rhs, to_string( lhs, "<=", rhs ) }; }
-    template< typename R > result operator> ( R const & rhs ) { return result{ lhs >  rhs, to_string( lhs, ">" , rhs ) }; }
-    template< typename R > result operator>=( R const & rhs ) { return result{ lhs >= rhs, to_string( lhs, ">=", rhs ) }; }
+    template< typename R > result operator==( R const & rhs ) { return decompose( lhs == rhs, "==", rhs ); }
+    template< typename R > result operator!=( R const & rhs ) { return decompose( lhs != rhs, "!=", rhs ); }
+    template< typename R > result operator< ( R const & rhs ) { return decompose( lhs <  rhs, "<" , rhs ); }
+    template< typename R > result operator<=( R const & rhs ) { return decompose( lhs <= rhs, "<=", rhs ); }
+    template< typename R > result operator> ( R const & rhs ) { return decompose( lhs >  rhs, ">" , rhs ); }
+    template< typename R > result operator>=( R const & rhs ) { return decompose( lhs >= rhs, ">=", rhs ); }
+
+    template< typename T, typename R >
+    result decompose( T const & passed, char const * op, R const & rhs )
+    {
+        return result{ !!passed, std::addressof( lhs ), op, std::addressof( rhs ), format_operands<operand, R> };
+    }
 };
 
 struct expression_decomposer
@@ -370,6 +400,12 @@ struct expression_decomposer
     }
 };
 
+inline void expect( result const & score, char const * file, int line, char const * expr )
+{
+    if ( ! score.passed )
+        throw failure{ location{ file, line }, expr, score.decomposition() };
+}
+
 } // namespace lest
 
 #ifdef __clang__
@@ -0,0 +1,68 @@
+#!/usr/bin/env python
+#
+# Copyright 2026-2026 by Martin Moene
+#
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#
+# script/lest-client.py, Python 3.4 and later
+#
+# Run tests in a test program that was started with option --serve=socket:
+#
+#   test --serve=/tmp/test.sock &
+#   python script/lest-client.py /tmp/test.sock --pass "[fast]"
+#   python script/lest-client.py /tmp/test.sock --serve-stop
+#
+
+import argparse
+import socket
+import sys
+
+def request( path, arguments ):
+    """Send arguments, copy report to stdout and return exit status of test run"""
+    with socket.socket( socket.AF_UNIX, socket.SOCK_STREAM ) as client:
+        client.connect( path )
+        client.sendall( ''.join( arg + '\n' for arg in arguments ).encode() + b'\n' )
+
+        status = None
+        while True:
+            data = client.recv( 4096 )
+            if not data:
+                break
+            if status is None:
+                report, nul, rest = data.partition( b'\0' )
+                sys.stdout.buffer.write( report )
+                sys.stdout.flush()
+                if nul:
+                    status = rest
+            else:
+                status += data
+
+    return int( status ) if status else 1
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Run tests in a test program started with option --serve=socket.',
+        epilog="""""",
+        formatter_class=argparse.RawTextHelpFormatter)
+
+    parser.add_argument(
+        'socket',
+        metavar='socket',
+        type=str,
+        help='path of the socket given with option --serve')
+
+    parser.add_argument(
+        'arguments',
+        metavar='arg',
+        nargs=argparse.REMAINDER,
+        help='options and test specification as for the test program, or --serve-stop')
+
+    args = parser.parse_args()
+
+    sys.exit( request( args.socket, args.arguments ) )
+
+if __name__ == '__main__':
+    main()
+
+# end of file
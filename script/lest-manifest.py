@@ -0,0 +1,96 @@
+#!/usr/bin/env python
+#
+# Copyright 2026-2026 by Martin Moene
+#
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#
+# script/lest-manifest.py, Python 3.4 and later
+#
+# List the tests of a test program compiled with lest_FEATURE_MANIFEST=1 as JSON,
+# like option --list-tests --format=json does, without running the program:
+#
+#   python script/lest-manifest.py test-program [test-program ...]
+#
+
+import argparse
+import codecs
+import json
+import re
+import struct
+import sys
+
+def section( path, name ):
+    """Return contents of the named section of an ELF file, or None"""
+    with open( path, 'rb' ) as f:
+        data = f.read()
+
+    if data[:4] != b'\x7fELF':
+        raise ValueError( "'{}' is not an ELF file".format( path ) )
+
+    is64   = data[4] == 2
+    endian = '<' if data[5] == 1 else '>'
+
+    if is64:
+        shoff, = struct.unpack_from( endian + 'Q', data, 0x28 )
+        shentsize, shnum, shstrndx = struct.unpack_from( endian + 'HHH', data, 0x3a )
+        header = endian + 'IIQQQQIIQQ'
+    else:
+        shoff, = struct.unpack_from( endian + 'I', data, 0x20 )
+        shentsize, shnum, shstrndx = struct.unpack_from( endian + 'HHH', data, 0x2e )
+        header = endian + 'IIIIIIIIII'
+
+    sections = [ struct.unpack_from( header, data, shoff + i * shentsize ) for i in range( shnum ) ]
+    strtab   = sections[ shstrndx ]
+
+    for sh in sections:
+        start = strtab[4] + sh[0]
+        if data[ start : data.index( b'\0', start ) ].decode() == name:
+            return data[ sh[4] : sh[4] + sh[5] ]
+    return None
+
+def name_of( proposition ):
+    """Concatenate the string literals of the proposition, e.g. "a" "[tag]" """
+    literals = re.findall( r'"((?:[^"\\]|\\.)*)"', proposition )
+    return b''.join( codecs.escape_decode( s.encode() )[0] for s in literals ).decode( 'utf-8', 'replace' )
+
+def tags_of( name ):
+    return re.findall( r'\[[^\]]*\]', name )
+
+def manifest( path ):
+    """Tests of a test program, entries 'file<tab>line<tab>proposition' separated by NULs"""
+    contents = section( path, 'lest_manifest' )
+    result = []
+    for entry in ( contents or b'' ).split( b'\0' ):
+        if entry:
+            file, line, proposition = entry.decode( 'utf-8', 'replace' ).split( '\t', 2 )
+            name = name_of( proposition )
+            result.append( { 'name': name, 'tags': tags_of( name ), 'file': file, 'line': int( line ) } )
+    return result
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='List the tests of test programs compiled with lest_FEATURE_MANIFEST=1 as JSON.',
+        epilog="""""",
+        formatter_class=argparse.RawTextHelpFormatter)
+
+    parser.add_argument(
+        'programs',
+        metavar='program',
+        type=str,
+        nargs='+',
+        help='test program to read the manifest from')
+
+    args = parser.parse_args()
+
+    tests = []
+    for program in args.programs:
+        tests.extend( manifest( program ) )
+
+    json.dump( tests, sys.stdout, indent=2 )
+    print()
+
+if __name__ == '__main__':
+    main()
+
+# end of file
@@ -13,8 +13,28 @@
 #endif
 
 #include "lest/lest.hpp"
+#include <cstdio>
+#include <fstream>
+#include <list>
 #include <set>
 
+#ifdef _WIN32
+# include <process.h>
+#else
+# include <unistd.h>
+#endif
+
+#if lest_FEATURE_ISOLATE
+# include <csignal>
+#endif
+
+#if lest_FEATURE_SERVE
+# include <csignal>
+# include <sys/socket.h>
+# include <sys/un.h>
+# include <sys/wait.h>
+#endif
+
 // Suppress:
 // - shadow warning for CASE inside CASE
 // - unused parameter, for cases without assertions such as [.std...]
@@ -40,13 +60,89 @@ const lest::test no_using_namespace_lest[] =
         EXPECT_NO_THROW( true );
         EXPECT_THROWS( true );
         EXPECT_THROWS_AS( true, std::exception );
+        lest_EXPECT_RANGE_EQ( std::string(), std::string() );
+        lest_EXPECT_ALL( std::string(), []( char ) { return true; } );
+        lest_CHECK( true );
+        lest_CHECK_NOT( false );
+        lest_CHECK_NO_THROW( true );
+        lest_CHECK_THROWS( true );
+        lest_CHECK_THROWS_AS( true, std::exception );
+        lest_EXPECT_RANGE_APPROX( std::vector<double>(), std::vector<double>(), lest::tolerance() );
     },
 };
 
 using namespace lest;
 
+// Name of a temporary file unique to this process: ctest may run the test
+// programs for several standards at once, in the same directory:
+
+std::string tmp_name( std::string name )
+{
+#ifdef _WIN32
+    return name + "-" + std::to_string( _getpid() ) + ".tmp";
+#else
+    return name + "-" + std::to_string( getpid() ) + ".tmp";
+#endif
+}
+
+#if lest_FEATURE_ISOLATE
+// Written by the worker processes forked by --isolate --jobs=N:
+
+const std::string pids_file = tmp_name( "test_lest-pids" );
+#endif
+
 struct S { void f(){} };
 
+struct Formatted { int value; static int count; };
+
+int Formatted::count = 0;
+
+bool operator==( Formatted a, Formatted b ) { return a.value == b.value; }
+
+std::ostream & operator<<( std::ostream & os, Formatted f ) { ++Formatted::count; return os << f.value; }
+
+#if lest_FEATURE_SERVE
+// Client side of option --serve: send request, return reply, or an empty
+// reply if the server cannot be reached or doesn't answer within 30 seconds:
+
+std::string request( std::string path, texts arguments )
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::memcpy( address.sun_path, path.c_str(), path.size() );
+
+    const int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+
+    int i = 0;
+    for ( ; connect( fd, reinterpret_cast<sockaddr const *>( &address ), sizeof address ) != 0 && i < 500; ++i )
+        usleep( 10000 );
+
+    timeval timeout = {};
+    timeout.tv_sec = 30;
+    setsockopt( fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout );
+
+    std::string message;
+    for ( auto & arg : arguments )
+        message += arg + "\n";
+    message += "\n";
+
+    if ( i == 500 || write( fd, message.data(), message.size() ) < 0 )
+    {
+        close( fd );
+        return "";
+    }
+
+    std::string reply;
+    char buffer[ 256 ];
+
+    for ( ssize_t n; ( n = read( fd, buffer, sizeof buffer ) ) > 0; )
+        reply.append( buffer, static_cast<std::size_t>( n ) );
+
+    close( fd );
+    return reply;
+}
+#endif
+
 const lest::test specification[] =
 {
     CASE( "Function to suppress warning \"expression has no effect\" acts as identity function" )
@@ -143,6 +239,21 @@ const lest::test specification[] =
 #endif
     },
 
+    CASE( "Failure exception type keeps texts that are not string literals" )
+    {
+        std::string name = "test-name";
+        failure msg( location{"filename.cpp", 765}, std::string("expr") + "ession", std::string("decomp") + "osition" );
+
+        std::ostringstream os;
+        report( os, msg, name );
+
+#ifndef __GNUG__
+        EXPECT( os.str() == "filename.cpp(765): failed: test-name: expression for decomposition\n" );
+#else
+        EXPECT( os.str() == "filename.cpp:765: failed: test-name: expression for decomposition\n" );
+#endif
+    },
+
     CASE( "Expect generates no message exception for a succeeding test" )
     {
         test pass = { CASE( "P" ) { EXPECT( true  ); } };
@@ -391,6 +502,193 @@ const lest::test specification[] =
         EXPECT( 0 == run( pass, os ) );
     },
 
+    CASE( "Check reports a failure and continues the test" )
+    {
+        test fail[] = {{ CASE( "F" ) { int i = 1; CHECK( i == 2 ); CHECK_NOT( i == 1 ); CHECK( i == 1 ); EXPECT( i == 3 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "failed: F: i == 2 for 1 == 2" ) );
+        EXPECT( std::string::npos != os.str().find( "failed: F: ! ( i == 1 ) for ! ( 1 == 1 )" ) );
+        EXPECT( std::string::npos != os.str().find( "failed: F: i == 3 for 1 == 3" ) );
+        EXPECT( std::string::npos != os.str().find( "1 out of 1 selected test failed." ) );
+    },
+
+    CASE( "Check counts a test with several failures as failed once" )
+    {
+        test fail[] = {{ CASE( "F" ) { for ( int i = 0; i < 3; ++i ) { CHECK( i < 0 ); } } },
+                       { CASE( "P" ) { CHECK( true ); CHECK_NOT( false ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "for 2 < 0" ) );
+        EXPECT( std::string::npos != os.str().find( "1 out of 2 selected tests failed." ) );
+    },
+
+    CASE( "Check_throws and check_no_throw report a failure and continue the test" )
+    {
+        test fail[] = {{ CASE( "F" ) { CHECK_THROWS( true ); CHECK_THROWS_AS( throw 1, std::exception ); CHECK_NO_THROW( throw 1 ); CHECK( ( throw 1, true ) ); EXPECT( false ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "failed: didn't get exception: F: true" ) );
+        EXPECT( std::string::npos != os.str().find( "failed: didn't get exception of type std::exception: F: throw 1" ) );
+        EXPECT( std::string::npos != os.str().find( "failed: got unexpected exception of unknown type: F: throw 1" ) );
+        EXPECT( std::string::npos != os.str().find( "failed: F: false" ) );
+    },
+
+    CASE( "Info and capture are reported with a failing assertion in their scope" )
+    {
+        test fail[] = {{ CASE( "F" )
+        {
+            for ( int i = 0; i < 3; ++i )
+            {
+                INFO( "iteration ", i );
+                int twice = 2 * i;
+                CAPTURE( i, twice );
+                EXPECT( i < 2 );
+            }
+        }}};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "failed: F\n  iteration 2\n  i := 2, twice := 4: i < 2 for 2 < 2" ) );
+    },
+
+    CASE( "Capture doesn't split its names at commas in string and character literals" )
+    {
+        test fail[] = {{ CASE( "F" ) { char c = ','; std::string s( "a,\"b" ); int n = 1; CAPTURE( c == ',', s == "a,\"b", n ); EXPECT( n == 2 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "failed: F\n  c == ',' := true, s == \"a,\\\"b\" := true, n := 1: n == 2 for 1 == 2" ) );
+    },
+
+    CASE( "Info and capture are reported with a failing check only while in scope" )
+    {
+        test fail[] = {{ CASE( "F" ) { { std::string s( "abc" ); CAPTURE( s ); CHECK( s.empty() ); } CHECK( false ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "failed: F\n  s := \"abc\": s.empty() for false" ) );
+        EXPECT( std::string::npos != os.str().find( "failed: F: false" ) );
+    },
+
+    CASE( "Info of a scope left via an exception caught in the test is not reported" )
+    {
+        test fail[] = {{ CASE( "F" ) { INFO( "outer" ); try { INFO( "inner" ); throw 1; } catch(...) {} EXPECT( false ); } },
+                       { CASE( "G" ) { try { INFO( "inner" ); throw 1; } catch(...) {} CHECK( false ); INFO( "next" ); EXPECT( false ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 2 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "failed: F\n  outer: false" ) );
+        EXPECT( std::string::npos != os.str().find( "failed: G: false" ) );
+        EXPECT( std::string::npos != os.str().find( "failed: G\n  next: false" ) );
+        EXPECT( std::string::npos == os.str().find( "inner" ) );
+    },
+
+    CASE( "Info is not formatted for a passing assertion" )
+    {
+        static int formatted; formatted = 0;
+        test pass[] = {{ CASE( "P" ) { INFO( ( ++formatted, "info" ) ); EXPECT( true ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, os ) );
+        EXPECT( 0 == formatted );
+
+        char const * opt[] = { "--pass" };
+
+        EXPECT( 0 == run( pass, lest::texts( opt, opt + 1 ), os ) );
+        EXPECT( 1 == formatted );
+        EXPECT( std::string::npos != os.str().find( "passed: P\n  info: true" ) );
+    },
+
+    CASE( "Expect_range_eq succeeds for ranges with equal elements" )
+    {
+        std::vector<int> v{ 1, 2, 3 };
+        std::list<int>   l{ 1, 2, 3 };
+        int              a[] = { 1, 2, 3 };
+
+        EXPECT_RANGE_EQ( v, a );
+        EXPECT_RANGE_EQ( v, l );
+        EXPECT_RANGE_EQ( std::string( "abc" ), std::string( "abc" ) );
+        EXPECT_RANGE_EQ( std::vector<double>(), std::list<double>() );
+    },
+
+    CASE( "Expect_range_eq reports the first mismatch and the number of mismatches" )
+    {
+        test fail[] = {{ CASE( "F" ) { std::vector<int> a( 100, 0 ), b( a ); b[50] = 1; b[60] = 2; EXPECT_RANGE_EQ( a, b ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "a == b for size 100 vs 100, 2 of 100 elements differ, first at [50]: [48..53) { 0, 0, 0, 0, 0, } vs { 0, 0, 1, 0, 0, }" ) );
+    },
+
+    CASE( "Expect_range_eq reports ranges that differ in size" )
+    {
+        test fail[] = {{ CASE( "F" ) { std::list<int> a{ 1, 2, 3 }; std::vector<int> b{ 1, 2 }; EXPECT_RANGE_EQ( a, b ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "a == b for size 3 vs 2, 0 of 2 elements differ: [0..3) { 1, 2, 3, } vs { 1, 2, }" ) );
+    },
+
+    CASE( "Expect_all reports the elements that do not satisfy the predicate" )
+    {
+        test pass[] = {{ CASE( "P" ) { std::vector<int> v{ 2, 4, 6 };       EXPECT_ALL( v, []( int x ) { return x % 2 == 0; } ); } }};
+        test fail[] = {{ CASE( "F" ) { std::vector<int> v{ 2, 4, 5, 6, 7 }; EXPECT_ALL( v, []( int x ) { return x % 2 == 0; } ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, os ) );
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "2 of 5 elements fail, first at [2]: [0..5) { 2, 4, 5, 6, 7, }" ) );
+    },
+
+    CASE( "Expect_range_approx succeeds for ranges within tolerance" )
+    {
+        std::vector<double> v{ 1.0, 2.0, 3.0 };
+        std::vector<double> w{ 1.0, 2.05, 3.0 };
+        std::vector<double> u{ 1.0, std::nextafter( 2.0, 3.0 ), 3.0 };
+        float               a[] = { 1.0f, 2.0f, 3.0f };
+
+        EXPECT_RANGE_APPROX( v, a, tolerance() );
+        EXPECT_RANGE_APPROX( v, w, tolerance().epsilon( 0.1 ) );
+        EXPECT_RANGE_APPROX( v, w, tolerance().epsilon( 0 ).absolute( 0.1 ) );
+        EXPECT_RANGE_APPROX( v, u, tolerance().epsilon( 0 ).ulps( 1 ) );
+    },
+
+    CASE( "Expect_range_approx reports the worst error and the number of elements out of tolerance" )
+    {
+        test fail[] = {{ CASE( "F" ) { std::vector<double> a( 100, 1.0 ), b( a ); b[50] = 1.5; b[60] = 3.0; EXPECT_RANGE_APPROX( a, b, tolerance() ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "a == approx b for size 100 vs 100, 2 of 100 elements out of tolerance, max abs error 2 at [60] (1 vs 3), max rel error 0.666667" ) );
+    },
+
     CASE( "Setup creates a fresh fixture for each section" )
     {
         SETUP("Context") {
@@ -423,6 +721,30 @@ const lest::test specification[] =
         EXPECT( Explicit{} );
     },
 
+    CASE( "Decomposition formats operands only for a failing or reported assertion" )
+    {
+        test pass[] = {{ CASE( "P" ) { EXPECT( Formatted{1} == Formatted{1} ); EXPECT_NOT( Formatted{1} == Formatted{2} ); } }};
+        test fail[] = {{ CASE( "F" ) { EXPECT( Formatted{1} == Formatted{2} ); } }};
+
+        std::ostringstream os;
+
+        Formatted::count = 0;
+
+        EXPECT( 0 == run( pass, os ) );
+        EXPECT( 0 == Formatted::count );
+
+        EXPECT( 0 == run( pass, { "--pass-zen" }, os ) );
+        EXPECT( 0 == Formatted::count );
+
+        EXPECT( 0 == run( pass, { "--pass" }, os ) );
+        EXPECT( 4 == Formatted::count );
+
+        EXPECT( 1 == run( fail, os ) );
+        EXPECT( 6 == Formatted::count );
+
+        EXPECT( std::string::npos != os.str().find( "Formatted{1} == Formatted{2} for 1 == 2" ) );
+    },
+
     CASE( "Decomposition formats nullptr as 'nullptr'" )
     {
         test pass[] = {{ CASE( "P" ) { EXPECT( nullptr == nullptr ); } }};
@@ -505,6 +827,100 @@ const lest::test specification[] =
         EXPECT( std::string::npos != os.str().find( "'\\x8' > '\\t' for '\\x08' > '\\t'" ) );
     },
 
+    CASE( "Decomposition formats escapes within a string and the extremes of integers" )
+    {
+        EXPECT( to_string( std::string( "a\\b\r\f\n\t\x1f\x7f\xff" ) ) == "\"a\\\\b\\r\\f\\n\\t\\x1f\x7f\xff\"" );
+#if ! lest_FEATURE_LITERAL_SUFFIX
+        EXPECT( to_string( std::numeric_limits<long long>::min() ) == "-9223372036854775808" );
+        EXPECT( to_string( std::numeric_limits<unsigned long long>::max() ) == "18446744073709551615" );
+        EXPECT( to_string( std::numeric_limits<short>::min() ) == "-32768" );
+#endif
+    },
+
+    CASE( "Decomposition elides container elements beyond option --max-print=N [commandline]" )
+    {
+        test fail[] = {{ CASE( "F" ) { std::vector<int> v( 10, 7 ); EXPECT( v == std::vector<int>() ); } }};
+
+        std::ostringstream os1, os2, os3;
+
+        EXPECT( 1 == run( fail, { "--max-print=3" }, os1 ) );
+        EXPECT( 1 == run( fail, { "--max-print=0" }, os2 ) );
+        EXPECT( 1 == run( fail, { "--max-print=x" }, os3 ) );
+
+        EXPECT( std::string::npos != os1.str().find( "for { 7, 7, 7, ... 7 more } == { }" ) );
+        EXPECT( std::string::npos != os2.str().find( "for { 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, } == { }" ) );
+        EXPECT( std::string::npos != os3.str().find( "Error: expecting non-negative number with option '--max-print'" ) );
+
+        EXPECT( printing().count == std::size_t( lest_FEATURE_MAX_PRINT ) );
+    },
+
+    CASE( "Decomposition elides container elements beyond lest_FEATURE_MAX_PRINT" )
+    {
+        test fail[] = {{ CASE( "F" ) { std::vector<int> v( lest_FEATURE_MAX_PRINT + 5, 7 ); EXPECT( v == std::vector<int>() ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "7, ... 5 more } == { }" ) );
+    },
+
+    CASE( "Decomposition elides containers nested beyond lest_FEATURE_MAX_PRINT_DEPTH" )
+    {
+        std::vector<int> leaf{ 1 };
+        std::vector<std::vector<int>> nested{ leaf };
+
+        printing().depth = 1;
+        const std::string str = to_string( nested );
+        printing().depth = lest_FEATURE_MAX_PRINT_DEPTH;
+
+        EXPECT( str == "{ { ... }, }" );
+    },
+
+    CASE( "Decomposition truncates an element beyond lest_FEATURE_MAX_PRINT_BYTES" )
+    {
+        std::vector<std::string> v{ std::string( 100, 'a' ), "b" };
+
+        printing().bytes = 10;
+        const std::string str = to_string( v );
+        printing().bytes = lest_FEATURE_MAX_PRINT_BYTES;
+
+        EXPECT( str == "{ \"aaaaaaa... 1 more }" );
+    },
+
+    CASE( "Decomposition truncates an element beyond lest_FEATURE_MAX_PRINT_BYTES between escape sequences" )
+    {
+        std::vector<std::string> v{ std::string( 100, '\x1f' ) };
+
+        printing().bytes = 10;
+        const std::string str = to_string( v );
+        printing().bytes = lest_FEATURE_MAX_PRINT_BYTES;
+
+        EXPECT( str == "{ \"\\x1f... }" );
+    },
+
+    CASE( "Decomposition leaves out a further element beyond lest_FEATURE_MAX_PRINT_BYTES" )
+    {
+        std::vector<std::string> v{ "b", std::string( 100, 'a' ), "c" };
+
+        printing().bytes = 20;
+        const std::string str = to_string( v );
+        printing().bytes = lest_FEATURE_MAX_PRINT_BYTES;
+
+        EXPECT( str == "{ \"b\", ... 2 more }" );
+    },
+
+    CASE( "Decomposition doesn't count the elided elements of a list" )
+    {
+        std::list<int> list{ 1, 2, 3 };
+
+        printing().count = 2;
+        const std::string str = to_string( list );
+        printing().count = lest_FEATURE_MAX_PRINT;
+
+        EXPECT( str == "{ 1, 2, ... more }" );
+    },
+
     CASE( "Decomposition formats std::string with double quotes" )
     {
         std::string hello( "hello" );
@@ -750,8 +1166,35 @@ const lest::test specification[] =
         EXPECT( 2 == run( fail, { "@"  , "![x" }, os ) );
         EXPECT( 2 == run( fail, { "*"  , "![x" }, os ) );
     },
+
+    CASE( "Test specifications with overlapping texts select tests [commandline]" )
+    {
+        test fail[] = {{ CASE( "abcd"  ) { EXPECT( false ); } },
+                       { CASE( "ABCE"  ) { EXPECT( false ); } },
+                       { CASE( "xbcdx" ) { EXPECT( false ); } },
+                       { CASE( "bbc"   ) { EXPECT( false ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, { "abce"         }, os ) );
+        EXPECT( 2 == run( fail, { "bcd"          }, os ) );
+        EXPECT( 3 == run( fail, { "abce", "bcd"  }, os ) );
+        EXPECT( 4 == run( fail, { "bc"           }, os ) );
+        EXPECT( 2 == run( fail, { "bc", "!cd"    }, os ) );
+        EXPECT( 1 == run( fail, { "bbc", "abcd!" }, os ) );
+    },
 #endif
 
+    CASE( "Empty texts of a test specification are not searched for [commandline]" )
+    {
+        lest::matcher match( { "", "bc", "" } );
+        std::vector<char> found( 3 );
+
+        match( "abcd", found );
+
+        EXPECT( found == std::vector<char>( { false, true, false } ) );
+    },
+
     CASE( "Unrecognised option recognised as such [commandline]" )
     {
         test fail[] = {{ CASE_E( "" ) { ; } }};
@@ -826,9 +1269,51 @@ const lest::test specification[] =
             EXPECT( std::string::npos == os.str().find( "[c]" ) );
             EXPECT( std::string::npos != os.str().find( "[x]" ) );
             EXPECT( std::string::npos != os.str().find( "[z]" ) );
+        }{
+            std::ostringstream os;
+
+            EXPECT( 0 == run( pass, {  "-g", "@" }, os ) );
+
+            EXPECT( os.str() == "   1 [b]\n   1 [c]\n   1 [x]\n   1 [z]\n" );
         }
     },
 
+    CASE( "Option --tags=expression selects tests by tags [commandline]" )
+    {
+        test pass[] = {{ CASE_E( "a [fast]"        ) { ; } },
+                       { CASE_E( "b [fast][net]"   ) { ; } },
+                       { CASE_E( "c [net][smoke]"  ) { ; } },
+                       { CASE_E( "d [fastx]"       ) { ; } },
+                       { CASE_E( "e [fast][hide]"  ) { ; } },
+                       { CASE_E( "f [fast][.slow]" ) { ; } }};
+
+        auto list = [&]( std::string expression ) -> std::string
+        {
+            std::ostringstream os;
+            run( pass, { "-l", "--tags=" + expression }, os );
+            return os.str();
+        };
+
+        EXPECT( list( "[fast]"                      ) == "a [fast]\nb [fast][net]\n" );
+        EXPECT( list( "[fast] & ![net] | [smoke]"   ) == "a [fast]\nc [net][smoke]\n" );
+        EXPECT( list( "[fast] & !([net] | [smoke])" ) == "a [fast]\n" );
+        EXPECT( list( "[fast] | [.slow]"            ) == "a [fast]\nb [fast][net]\nf [fast][.slow]\n" );
+        EXPECT( list( "[hide]"                      ) == "e [fast][hide]\n" );
+        EXPECT( list( "[unknown]"                  ) == ""             );
+    },
+
+    CASE( "Option --tags=expression is recognised as invalid for malformed expressions [commandline]" )
+    {
+        std::ostringstream os;
+
+        EXPECT( 1 == run( { }, { "--tags=[a] &"  }, os ) );
+        EXPECT( 1 == run( { }, { "--tags=([a]"   }, os ) );
+        EXPECT( 1 == run( { }, { "--tags=[a"     }, os ) );
+        EXPECT( 1 == run( { }, { "--tags=[a] [b]" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "invalid tag expression" ) );
+    },
+
     CASE( "Option -l,--list-tests lists selected tests [commandline]" )
     {
         test pass[] = {{ CASE_E( "a b c" ) { ; } },
@@ -851,6 +1336,24 @@ const lest::test specification[] =
         }
     },
 
+    CASE( "Option --format=json with -l,--list-tests lists selected tests as JSON [commandline]" )
+    {
+        test pass[] = {{ CASE_E( "a \"b\" [x][y]" ) { ; } },
+                       { CASE_E( "c\td"            ) { ; } }};
+
+        std::ostringstream os1, os2;
+
+        EXPECT( 0 == run( pass, { "-l", "--format=json"    }, os1 ) );
+        EXPECT( 0 == run( pass, { "-l", "--format=json", "zzz" }, os2 ) );
+        EXPECT( 1 == run( pass, { "-l", "--format=xml"     }, os2 ) );
+
+        EXPECT( os1.str() == "[\n"
+            "  { \"name\": \"a \\\"b\\\" [x][y]\", \"tags\": [\"[x]\", \"[y]\"] },\n"
+            "  { \"name\": \"c\\td\", \"tags\": [] }\n"
+            "]\n" );
+        EXPECT( os2.str().substr( 0, 3 ) == "[]\n" );
+    },
+
     CASE( "Option -p,--pass also reports passing selected tests [commandline]" )
     {
         test pass[] = {{ CASE( "a b c" ) { EXPECT( true ); } }};
@@ -874,6 +1377,19 @@ const lest::test specification[] =
         }
     },
 
+    CASE( "Option -p,--pass doesn't keep the texts of passing assertions until the test ends [commandline]" )
+    {
+        static std::size_t before, after;
+
+        test pass[] = {{ CASE( "a" ) { before = lest::arena().size(); EXPECT( 1 == 1 ); CHECK_NOT( 1 == 2 ); EXPECT_THROWS_AS( throw 42, int ); after = lest::arena().size(); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--pass" }, os ) );
+
+        EXPECT( before == after );
+    },
+
     CASE( "Option -z,--pass-zen also reports passing selected tests, but not expansion [commandline]" )
     {
         test pass[] = {{ CASE( "a b c" ) { EXPECT( true ); } }};
@@ -1103,6 +1619,637 @@ const lest::test specification[] =
         EXPECT( std::string::npos != os.str().find( "Error" ) );
     },
 
+    CASE( "Benchmark is hidden unless selected [commandline]" )
+    {
+        test bench[] = {{ BENCHMARK( "B" ) { lest::do_not_optimize( 42 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( bench, { "--count" }, os ) );
+        EXPECT( 0 == run( bench, { "--count", "[.benchmark]" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "0 selected tests" ) );
+        EXPECT( std::string::npos != os.str().find( "1 selected test\n" ) );
+    },
+
+    CASE( "Option --benchmark-time=n reports statistics of a selected benchmark [commandline]" )
+    {
+        test bench[] = {{ BENCHMARK( "B" ) { int x = 42; lest::do_not_optimize( x ); lest::clobber_memory(); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( bench, { "--benchmark-time=10", "B" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "B [.benchmark]: min " ) );
+        EXPECT( std::string::npos != os.str().find( ", median " ) );
+        EXPECT( std::string::npos != os.str().find( ", mad " ) );
+        EXPECT( std::string::npos != os.str().find( " samples of " ) );
+    },
+
+    CASE( "Benchmark fails for a failing assertion in its body" )
+    {
+        test bench[] = {{ BENCHMARK( "B" ) { EXPECT( false ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( bench, { "--benchmark-time=0", "B" }, os ) );
+    },
+
+    CASE( "Benchmark excludes time it is paused from its measurement" )
+    {
+        test bench = { BENCHMARK( "B" ) { lest_env.pause(); lest::timer t; while ( t.elapsed_seconds() < 0.002 ) {} lest_env.resume(); } };
+
+        std::ostringstream os;
+        lest::options option; option.benchmark = 0;
+        lest::env output( os, option );
+
+        const lest::measurement result = lest::benchmark( bench, output );
+
+        EXPECT( result.stats.samples >= 2u );
+        EXPECT( result.stats.median < 0.001 );
+    },
+
+    CASE( "Option --baseline-save=file saves the environment and statistics per benchmark [commandline]" )
+    {
+        test bench[] = {{ BENCHMARK( "B" ) { lest::do_not_optimize( 42 ); } }};
+
+        const std::string filename = tmp_name( "test_lest-baseline-save" );
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( bench, { "--benchmark-time=0", "--baseline-save=" + filename, "B" }, os ) );
+
+        std::ifstream in( filename );
+        std::string saved( ( std::istreambuf_iterator<char>( in ) ), std::istreambuf_iterator<char>() );
+        in.close();
+        std::remove( filename.c_str() );
+
+        EXPECT( std::string::npos != saved.find( "\n# compiler: " + lest::compiler() + "\n" ) );
+        EXPECT( std::string::npos != saved.find( "\t10\tB [.benchmark]\n" ) );
+    },
+
+    CASE( "Option --baseline-compare=file fails a significantly slower benchmark and marks a faster one [commandline]" )
+    {
+        test bench[] = {{ BENCHMARK( "B" ) { lest::timer t; while ( t.elapsed_seconds() < 0.0001 ) {} } }};
+
+        const std::string filename = tmp_name( "test_lest-baseline-compare" );
+
+        std::ostringstream slower, faster, ignored;
+
+        std::ofstream( filename ) << "# lest baseline\n1e-06\t0\t1e-06\t1e-08\t10\tB [.benchmark]\n";
+
+        const int slow = run( bench, { "--benchmark-time=0", "--baseline-compare=" + filename, "B" }, slower );
+
+        std::ofstream( filename ) << "# lest baseline\n1\t0\t1\t0.01\t10\tB [.benchmark]\n";
+
+        const int fast = run( bench, { "--benchmark-time=0", "--baseline-compare=" + filename, "B" }, faster );
+
+        std::ofstream( filename ) << "# lest baseline\n1e-06\t0\t1e-06\t1e-08\t10\tB [.benchmark]\n";
+
+        const int same = run( bench, { "--benchmark-time=0", "--baseline-compare=" + filename, "--baseline-threshold=1000000", "B" }, ignored );
+
+        std::remove( filename.c_str() );
+
+        EXPECT( 1 == slow );
+        EXPECT( 0 == fast );
+        EXPECT( 0 == same );
+        EXPECT( std::string::npos != slower.str().find( filename + ":2: failed: slower than baseline: B [.benchmark]: median " ) );
+        EXPECT( std::string::npos != faster.str().find( filename + ":2: passed: faster than baseline: B [.benchmark]: median " ) );
+        EXPECT( std::string::npos == ignored.str().find( "baseline" ) );
+    },
+
+    CASE( "Option --baseline-compare=file reports a test with a single duration from option --time as not significantly slower [commandline]" )
+    {
+        test pass[] = {{ CASE( "a" ) { lest::timer t; while ( t.elapsed_seconds() < 0.001 ) {} } }};
+
+        const std::string filename = tmp_name( "test_lest-baseline-time" );
+
+        std::ofstream( filename ) << "1e-06\t0\t1e-06\t0\t10\ta\n";
+
+        std::ostringstream os;
+
+        const int failures = run( pass, { "--time", "--baseline-compare=" + filename }, os );
+
+        std::remove( filename.c_str() );
+
+        EXPECT( 0 == failures );
+        EXPECT( std::string::npos != os.str().find( filename + ":1: passed: not significantly slower than baseline: a: median " ) );
+    },
+
+    CASE( "Option --baseline-compare=file fails a slower test timed with options --time and --repeat [commandline]" )
+    {
+        test pass[] = {{ CASE( "a" ) { lest::timer t; while ( t.elapsed_seconds() < 0.001 ) {} } }};
+
+        const std::string filename = tmp_name( "test_lest-baseline-repeat" );
+
+        std::ofstream( filename ) << "1e-06\t0\t1e-06\t0\t10\ta\n";
+
+        std::ostringstream os;
+
+        const int failures = run( pass, { "--time", "--repeat=10", "--baseline-compare=" + filename }, os );
+
+        std::remove( filename.c_str() );
+
+        EXPECT( 1 == failures );
+        EXPECT( std::string::npos != os.str().find( filename + ":1: failed: slower than baseline: a: median " ) );
+    },
+
+    CASE( "Option --baseline-compare=file reports a file that cannot be read [commandline]" )
+    {
+        std::ostringstream os;
+
+        EXPECT( 1 == run( { }, { "--baseline-compare=nonexisting-file.tmp" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "Error" ) );
+    },
+
+    CASE( "Expect_instructions_below succeeds for a region within the limit" )
+    {
+        int x = 0;
+
+        EXPECT_INSTRUCTIONS_BELOW( 1000000, x += 1 );
+
+        EXPECT( x == 1 );
+    },
+
+    CASE( "Expect_instructions_below fails for a region beyond the limit, if instructions can be counted" )
+    {
+        test fail[] = {{ CASE( "F" ) { int x = 0; EXPECT_INSTRUCTIONS_BELOW( 0, x += 1 ); } }};
+
+        const bool counted = lest::counters( { lest::counters::instructions } ).available( lest::counters::instructions );
+
+        std::ostringstream os;
+
+        EXPECT( ( counted ? 1 : 0 ) == run( fail, os ) );
+
+        if ( counted )
+            EXPECT( std::string::npos != os.str().find( "failed: F: instructions( x += 1 ) < 0 for " ) );
+    },
+
+    // Depend on the speed of the machine at the time; select with "[.timing]":
+
+    CASE( "Expect_faster succeeds for a candidate that is faster by the given factor" "[.timing]" )
+    {
+        test pass[] = {{ CASE( "P" ) {
+            auto slow = []{ unsigned sum = 0; for ( unsigned i = 0; i < 20000; ++i ) do_not_optimize( sum += i ); return sum; };
+            auto fast = []{ unsigned sum = 0; for ( unsigned i = 0; i < 2000; ++i ) do_not_optimize( sum += i ); return sum; };
+            EXPECT_FASTER( slow, fast, 2 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--benchmark-time=50" }, os ) );
+    },
+
+    CASE( "Expect_faster fails for a candidate that is not faster, with a statistical summary" "[.timing]" )
+    {
+        test fail[] = {{ CASE( "F" ) {
+            auto slow = []{ unsigned sum = 0; for ( unsigned i = 0; i < 20000; ++i ) do_not_optimize( sum += i ); return sum; };
+            auto fast = []{ unsigned sum = 0; for ( unsigned i = 0; i < 2000; ++i ) do_not_optimize( sum += i ); return sum; };
+            EXPECT_FASTER( fast, slow, 1 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, { "--benchmark-time=50" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "failed: F: speedup( fast, slow ) >= 1 for speedup 0." ) );
+        EXPECT( std::string::npos != os.str().find( ", 90% interval 0." ) );
+    },
+
+    CASE( "Speedup and its bootstrap interval are the ratio of mean times" )
+    {
+        const lest::speedup result = lest::bootstrap_speedup( { 2, 4, 2, 4 }, { 1, 2, 1, 2 } );
+
+        EXPECT( result.ratio == approx( 2 ) );
+        EXPECT( result.low   == approx( 2 ) );
+        EXPECT( result.high  == approx( 2 ) );
+        EXPECT( result.pairs == 4u );
+    },
+
+    CASE( "Expect_complexity succeeds for a body of the expected or a lower complexity" "[.timing]" )
+    {
+        test pass[] = {{ CASE( "P" ) {
+            auto linear = []( std::size_t n ) { unsigned sum = 0; for ( std::size_t i = 0; i < n; ++i ) do_not_optimize( sum += unsigned( i ) ); return sum; };
+            EXPECT_COMPLEXITY( linear, lest::sizes( 1024, 65536, 4 ), oNLogN );
+            EXPECT_COMPLEXITY( linear, lest::sizes( 1024, 65536, 4 ), lest::complexities::oN2 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--benchmark-time=50" }, os ) );
+    },
+
+    CASE( "Expect_complexity fails for a body of a higher complexity, with the best fit" "[.timing]" )
+    {
+        test fail[] = {{ CASE( "F" ) {
+            auto quadratic = []( std::size_t n ) { unsigned sum = 0; for ( std::size_t i = 0; i < n; ++i ) for ( std::size_t k = 0; k < n; ++k ) do_not_optimize( sum += unsigned( i ^ k ) ); return sum; };
+            EXPECT_COMPLEXITY( quadratic, lest::sizes( 32, 512 ), oN ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, { "--benchmark-time=50" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "failed: F: complexity( quadratic ) <= oN for best fit O(n" ) );
+        EXPECT( std::string::npos != os.str().find( "; O(n): rms " ) );
+    },
+
+    CASE( "Complexity fit selects the class of the times, with its relative rms error" )
+    {
+        const std::vector<std::size_t> n = lest::sizes( 16, 4096, 4 );
+
+        std::vector<double> n_log_n, n_squared;
+        for ( auto size : n )
+        {
+            n_log_n  .push_back( 3e-9 * static_cast<double>( size ) * std::log2( static_cast<double>( size ) ) );
+            n_squared.push_back( 2e-9 * static_cast<double>( size * size ) );
+        }
+
+        EXPECT( n == std::vector<std::size_t>( { 16, 64, 256, 1024, 4096 } ) );
+
+        EXPECT( lest::fit_complexity( n, n_log_n   ).best == lest::complexities::oNLogN );
+        EXPECT( lest::fit_complexity( n, n_squared ).best == lest::complexities::oN2 );
+        EXPECT( lest::fit_complexity( n, n_squared ).rms[ lest::complexities::oN2 ] < 1e-9 );
+        EXPECT( lest::fit_complexity( n, n_squared ).rms[ lest::complexities::oN  ] > 0.1 );
+    },
+
+    CASE( "Complexity sizes stop before the next size would overflow" )
+    {
+        const std::size_t most = (std::numeric_limits<std::size_t>::max)();
+
+        EXPECT( lest::sizes( 1, most ).size() == std::size_t( std::numeric_limits<std::size_t>::digits ) );
+        EXPECT( lest::sizes( most, most ) == std::vector<std::size_t>( { most } ) );
+    },
+
+    CASE( "Expect_no_alloc fails if allocations are not counted" )
+    {
+        test fail[] = {{ CASE( "F" ) { EXPECT_NO_ALLOC( std::string( 100, 'x' ) ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "failed: F: allocations( std::string( 100, 'x' ) ) <= 0 for allocations not counted, include lest/lest_alloc.hpp" ) );
+    },
+
+#if lest__perf_counters
+    CASE( "Option --counters reports the available events of a test with option --time [commandline]" )
+    {
+        test pass[] = {{ CASE( "a" ) { ; } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--time", "--counters" }, os ) );
+
+        if ( lest::counters().any() )
+            EXPECT( std::string::npos != os.str().find( " ms: a\n   events: " ) );
+    },
+#endif
+
+    CASE( "Statistics of a sample are summarised properly" )
+    {
+        const std::vector<double> sample = { 4, 1, 100, 3, 2 };
+
+        const lest::statistics stats = lest::summarise( sample );
+
+        EXPECT( stats.samples == 5u );
+        EXPECT( stats.min     == 1 );
+        EXPECT( stats.median  == 3 );
+        EXPECT( stats.mean    == 22 );
+        EXPECT( stats.mad     == 1 );
+        EXPECT( stats.sd      == approx( 43.6176 ).epsilon( 1e-5 ) );
+    },
+
+    CASE( "Option --shard=i/n selects disjoint shards that cover the selected tests [commandline]" )
+    {
+        test pass[] = {{ CASE_E( "t0" ) { ; } }, { CASE_E( "t1" ) { ; } }, { CASE_E( "t2" ) { ; } },
+                       { CASE_E( "t3" ) { ; } }, { CASE_E( "t4" ) { ; } }, { CASE_E( "t5" ) { ; } },
+                       { CASE_E( "t6" ) { ; } }, { CASE_E( "t7" ) { ; } }, { CASE_E( "t8" ) { ; } },
+                       { CASE_E( "x9 [hide]" ) { ; } }};
+
+        for ( auto order : { "--order=declared", "--order=random" } )
+        {
+            std::multiset<std::string> names;
+
+            for ( auto shard : { "--shard=0/3", "--shard=1/3", "--shard=2/3" } )
+            {
+                std::ostringstream os;
+
+                EXPECT( 0 == run( pass, { "-l", order, "--random-seed=42", shard }, os ) );
+
+                std::istringstream is( os.str() );
+                for ( std::string name; std::getline( is, name ); )
+                    names.insert( name );
+            }
+
+            EXPECT( 9u == names.size() );
+            EXPECT( 9u == std::set<std::string>( names.begin(), names.end() ).size() );
+        }
+    },
+
+    CASE( "Option --shard-times=file balances shards by duration [commandline]" )
+    {
+        test pass[] = {{ CASE_E( "a" ) { ; } }, { CASE_E( "b" ) { ; } }, { CASE_E( "c" ) { ; } },
+                       { CASE_E( "d" ) { ; } }, { CASE_E( "e" ) { ; } }};
+
+        const std::string filename = tmp_name( "test_lest-shard-times" );
+
+        std::ofstream( filename ) << "100 ms: a\n 40 ms: b\n 30 ms: c\n 30 ms: d\nElapsed time: 0.2 s\n";
+
+        std::ostringstream os0, os1;
+
+        EXPECT( 0 == run( pass, { "-l", "--shard=0/2", "--shard-times=" + filename }, os0 ) );
+        EXPECT( 0 == run( pass, { "-l", "--shard=1/2", "--shard-times=" + filename }, os1 ) );
+
+        std::remove( filename.c_str() );
+
+        EXPECT( os0.str() == "a\nd\n" );
+        EXPECT( os1.str() == "b\nc\ne\n" );
+    },
+
+    CASE( "Option --tests-from=file selects the tests named in file [commandline]" )
+    {
+        test pass[] = {{ CASE_E( "a"        ) { ; } }, { CASE_E( "ab"       ) { ; } },
+                       { CASE_E( "b [hide]" ) { ; } }, { CASE_E( "c [x]"    ) { ; } }};
+
+        const std::string filename = tmp_name( "test_lest-tests-from" );
+
+        std::ofstream( filename ) << "a\nb [hide]\r\nc [x]\nunknown\n";
+
+        std::ostringstream os1, os2;
+
+        EXPECT( 0 == run( pass, { "-l", "--tests-from=" + filename        }, os1 ) );
+        EXPECT( 0 == run( pass, { "-l", "--tests-from=" + filename, "[x]" }, os2 ) );
+
+        std::remove( filename.c_str() );
+
+        EXPECT( os1.str() == "a\nb [hide]\nc [x]\n" );
+        EXPECT( os2.str() == "c [x]\n" );
+    },
+
+    CASE( "Option --tests-from=file reports a file that cannot be read [commandline]" )
+    {
+        std::ostringstream os;
+
+        EXPECT( 1 == run( { }, { "--tests-from=nonexisting-file.tmp" }, os ) );
+        EXPECT( 1 == run( { }, { "--tests-from"                      }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "Error" ) );
+    },
+
+    CASE( "Option --shard=i/n is recognised as invalid for i >= n [commandline]" )
+    {
+        std::ostringstream os;
+
+        EXPECT( 1 == run( { }, { "--shard=3/3" }, os ) );
+        EXPECT( 1 == run( { }, { "--shard=1"   }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "Error" ) );
+    },
+
+#if lest_FEATURE_JOBS
+    CASE( "Option --jobs=N runs tests concurrently, reports in declared order [commandline]" )
+    {
+        test fail[] = {{ CASE( "a" ) { EXPECT( 1 == 2 ); } },
+                       { CASE( "b" ) { EXPECT( 1 == 1 ); } },
+                       { CASE( "c" ) { EXPECT( 1 == 3 ); } },
+                       { CASE( "d" ) { EXPECT( 1 == 4 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 3 == run( fail, { "--jobs=3" }, os ) );
+
+        EXPECT( os.str().find( ": a:" ) < os.str().find( ": c:" ) );
+        EXPECT( os.str().find( ": c:" ) < os.str().find( ": d:" ) );
+        EXPECT( std::string::npos != os.str().find( "3 out of 4 selected tests failed." ) );
+    },
+
+    CASE( "Option --jobs=N with --repeat=N counts all runs [commandline]" )
+    {
+        test fail[] = {{ CASE( "a" ) { EXPECT( false ); } },
+                       { CASE( "b" ) { EXPECT( true  ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 3 == run( fail, { "--jobs=2", "--repeat=3" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "3 out of 6 selected tests failed." ) );
+    },
+
+    CASE( "Option --jobs=N with --abort stops at first failure [commandline]" )
+    {
+        test fail[] = {{ CASE( "a" ) { EXPECT( false ); } },
+                       { CASE( "b" ) { EXPECT( false ); } },
+                       { CASE( "c" ) { EXPECT( false ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, { "--jobs=2", "--abort" }, os ) );
+    },
+
+    CASE( "Option --jobs=N runs tests tagged [serial] after the others [commandline]" )
+    {
+        test fail[] = {{ CASE( "a [serial]" ) { EXPECT( false ); } },
+                       { CASE( "b"          ) { EXPECT( false ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 2 == run( fail, { "--jobs=2" }, os ) );
+
+        EXPECT( os.str().find( ": b:" ) < os.str().find( ": a [serial]:" ) );
+    },
+
+    CASE( "Option --jobs=N with -t,--time reports all selected tests [commandline]" )
+    {
+        test pass[] = {{ CASE( "a b c" ) { EXPECT( true ); } },
+                       { CASE( "x y z" ) { EXPECT( true ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--jobs=2", "--time" }, os ) );
+
+        EXPECT( os.str().find( "ms: a b c" ) < os.str().find( "ms: x y z" ) );
+    },
+
+    CASE( "Option --jobs={non-positive-number} is recognised as invalid [commandline]" )
+    {
+        std::ostringstream os;
+
+        EXPECT( 1 == run( { }, { "--jobs=0" }, os ) );
+        EXPECT( 1 == run( { }, { "--jobs=-2" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "Error" ) );
+    },
+#endif
+
+#if lest_FEATURE_ISOLATE
+    CASE( "Option --isolate reports a crashing test and continues [commandline]" )
+    {
+        test fail[] = {{ CASE( "a" ) { std::raise( SIGSEGV ); } },
+                       { CASE( "b" ) { EXPECT( 1 == 2 ); } },
+                       { CASE( "c" ) { EXPECT( 1 == 1 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 2 == run( fail, { "--isolate" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "a: failed: terminated by signal" ) );
+        EXPECT( std::string::npos != os.str().find( "failed: b: 1 == 2 for 1 == 2" ) );
+        EXPECT( std::string::npos != os.str().find( "2 out of 3 selected tests failed." ) );
+    },
+
+    CASE( "Option --isolate reports passing tests from the child process [commandline]" )
+    {
+        test pass[] = {{ CASE( "a b c" ) { EXPECT( true ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--isolate", "--pass" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "passed: a b c: true for true" ) );
+    },
+
+    CASE( "Option --isolate reports a test that exits or throws [commandline]" )
+    {
+        test fail[] = {{ CASE_E( "a" ) { std::exit( 7 ); } },
+                       { CASE_E( "b" ) { throw std::runtime_error( "oops" ); } },
+                       { CASE_E( "c" ) { std::exit( 1 ); } },
+                       { CASE_E( "d" ) { std::exit( 0 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 4 == run( fail, { "--isolate" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "a: failed: exited with code 7" ) );
+        EXPECT( std::string::npos != os.str().find( "b: failed: got unexpected exception with message \"oops\"" ) );
+        EXPECT( std::string::npos != os.str().find( "c: failed: exited with code 1" ) );
+        EXPECT( std::string::npos != os.str().find( "d: failed: exited with code 0" ) );
+#if lest_FEATURE_JOBS
+        std::ostringstream os2;
+
+        EXPECT( 4 == run( fail, { "--isolate", "--jobs=2" }, os2 ) );
+
+        EXPECT( std::string::npos != os2.str().find( "c: failed: exited with code 1" ) );
+        EXPECT( std::string::npos != os2.str().find( "d: failed: exited with code 0" ) );
+#endif
+    },
+
+    CASE( "Option --limit-memory=N limits memory of an isolated test [commandline]" )
+    {
+        test fail[] = {{ CASE( "a" ) { EXPECT_NO_THROW( std::vector<char>( std::size_t( 256 ) << 20, 'x' ) ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( fail, { "--isolate"                     }, os ) );
+        EXPECT( 1 == run( fail, { "--isolate", "--limit-memory=64" }, os ) );
+    },
+
+#if lest_FEATURE_JOBS
+    CASE( "Option --isolate with --jobs=N replaces a crashed worker and reports in order [commandline]" )
+    {
+        test fail[] = {{ CASE( "t0" ) { EXPECT( 1 == 1 ); } }, { CASE( "t1" ) { std::raise( SIGSEGV ); } },
+                       { CASE( "t2" ) { EXPECT( 1 == 2 ); } }, { CASE( "t3" ) { std::raise( SIGKILL ); } },
+                       { CASE( "t4" ) { EXPECT( 1 == 1 ); } }, { CASE( "t5" ) { EXPECT( 1 == 1 ); } },
+                       { CASE( "t6" ) { EXPECT( 1 == 1 ); } }, { CASE( "t7" ) { EXPECT( 1 == 1 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 3 == run( fail, { "--isolate", "--jobs=2", "--pass" }, os ) );
+
+        const std::string out = os.str();
+
+        EXPECT( std::string::npos != out.find( "t1: failed: terminated by signal" ) );
+        EXPECT( std::string::npos != out.find( "t3: failed: terminated by signal" ) );
+        EXPECT( std::string::npos != out.find( "3 out of 8 selected tests failed." ) );
+
+        EXPECT( out.find( "passed: t0" ) < out.find( "t1: failed" ) );
+        EXPECT( out.find( "failed: t2" ) < out.find( "t3: failed" ) );
+        EXPECT( out.find( "t3: failed" ) < out.find( "passed: t7" ) );
+    },
+
+    CASE( "Option --isolate with --jobs=N runs tests in N worker processes [commandline]" )
+    {
+#define lest_PID_TEST( name ) { CASE( name ) { std::ofstream( pids_file, std::ios::app ) << getpid() << "\n"; } }
+
+        test pass[] = { lest_PID_TEST( "a" ), lest_PID_TEST( "b" ), lest_PID_TEST( "c" ), lest_PID_TEST( "d" ),
+                        lest_PID_TEST( "e" ), lest_PID_TEST( "f" ), lest_PID_TEST( "g" ), lest_PID_TEST( "h" ) };
+
+#undef lest_PID_TEST
+
+        std::remove( pids_file.c_str() );
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--isolate", "--jobs=2" }, os ) );
+
+        std::ifstream is( pids_file );
+        std::multiset<std::string> pids;
+
+        for ( std::string pid; std::getline( is, pid ); )
+            pids.insert( pid );
+
+        std::remove( pids_file.c_str() );
+
+        EXPECT( 8u == pids.size() );
+        EXPECT( 2u >= std::set<std::string>( pids.begin(), pids.end() ).size() );
+    },
+#endif
+
+    CASE( "Option --isolate with -t,--time reports duration of selected tests [commandline]" )
+    {
+        test pass[] = {{ CASE( "a b c" ) { EXPECT( true ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--isolate", "--time" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "ms: a b c" ) );
+    },
+#endif
+
+#if lest_FEATURE_SERVE
+    CASE( "Option --serve=socket runs tests as requested until stopped [commandline]" )
+    {
+        test fail[] = {{ CASE( "a" ) { EXPECT( 1 == 1 ); } },
+                       { CASE( "b" ) { EXPECT( 1 == 2 ); } }};
+
+        const std::string path = tmp_name( "test_lest-serve" );
+
+        std::remove( path.c_str() );
+        std::cout.flush();
+        const pid_t pid = fork();
+
+        if ( pid == 0 )
+        {
+            std::ostringstream os;
+            _exit( run( fail, { "--serve=" + path }, os ) );
+        }
+
+        const std::string pass = request( path, { "--pass", "a" } );
+        const std::string all  = request( path, { } );
+        const std::string nest = request( path, { "--serve=other.sock" } );
+        const std::string stop = request( path, { "--serve-stop" } );
+
+        // don't wait forever for a server that missed --serve-stop:
+        if ( stop != std::string( "\0" "0", 2 ) )
+            kill( pid, SIGKILL );
+
+        int status = 0;
+        for ( int i = 0; waitpid( pid, &status, WNOHANG ) == 0; ++i )
+        {
+            if ( i == 500 )
+                kill( pid, SIGKILL );
+            usleep( 10000 );
+        }
+
+        EXPECT( std::string::npos != pass.find( "passed: a: 1 == 1 for 1 == 1" ) );
+        EXPECT( pass.substr( pass.size() - 2 ) == std::string( "\0" "0", 2 ) );
+        EXPECT( all.substr( all.size() - 2 )   == std::string( "\0" "1", 2 ) );
+        EXPECT( std::string::npos != all.find( "1 out of 2 selected tests failed." ) );
+        EXPECT( std::string::npos != nest.find( "Error: option --serve cannot be requested" ) );
+        EXPECT( stop == std::string( "\0" "0", 2 ) );
+        EXPECT( WIFEXITED( status ) );
+        EXPECT( 0 == WEXITSTATUS( status ) );
+    },
+#endif
+
     CASE( "Option --version is recognised [commandline]" )
     {
         std::ostringstream os;
@@ -1142,8 +2289,18 @@ const lest::test specification[] =
     CASE( "lest features" "[.feature]" )
     {
         lest_PRESENT( lest_FEATURE_COLOURISE );
+        lest_PRESENT( lest_FEATURE_HEAP_PROFILE );
+        lest_PRESENT( lest_FEATURE_ISOLATE );
+        lest_PRESENT( lest_FEATURE_JOBS );
+        lest_PRESENT( lest_FEATURE_LINKER_REGISTER );
         lest_PRESENT( lest_FEATURE_LITERAL_SUFFIX );
+        lest_PRESENT( lest_FEATURE_MANIFEST );
+        lest_PRESENT( lest_FEATURE_MAX_PRINT );
+        lest_PRESENT( lest_FEATURE_MAX_PRINT_BYTES );
+        lest_PRESENT( lest_FEATURE_MAX_PRINT_DEPTH );
+        lest_PRESENT( lest_FEATURE_PERF_COUNTERS );
         lest_PRESENT( lest_FEATURE_REGEX_SEARCH );
+        lest_PRESENT( lest_FEATURE_SERVE );
 #ifdef lest_FEATURE_RTTI
         lest_PRESENT( lest_FEATURE_RTTI );
 #else
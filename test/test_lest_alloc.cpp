@@ -0,0 +1,238 @@
+// Copyright 2026 by Martin Moene
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "lest/lest_alloc.hpp"
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Suppress:
+// - shadow warning for CASE inside CASE
+// - unused parameter, for cases without assertions
+#ifdef __clang__
+# pragma clang diagnostic ignored "-Wmissing-braces"
+# pragma clang diagnostic ignored "-Wshadow"
+# pragma clang diagnostic ignored "-Wunused-parameter"
+#elif defined __GNUC__
+# pragma GCC   diagnostic ignored "-Wmissing-braces"
+# pragma GCC   diagnostic ignored "-Wshadow"
+# pragma GCC   diagnostic ignored "-Wunused-parameter"
+#endif
+
+using namespace lest;
+
+#if lest__heap_profile
+
+# include <unistd.h>
+
+// Name of the heap profile, unique to this process: ctest may run the test
+// programs for several standards at once, in the same directory:
+
+const std::string heap_file = "test_lest_alloc-heap-" + std::to_string( getpid() ) + ".tmp";
+
+// Allocating functions with a name in the heap profile, given -rdynamic; in
+// optimised builds kept out of line and on the stack by not ending in a tail
+// call of operator new:
+
+lest_NOINLINE std::vector<char> make_block( std::size_t n ) { return std::vector<char>( n ); }
+
+lest_NOINLINE char * leak_block( std::size_t n ) { return new char[ n ](); }
+
+char * leaked = nullptr;
+
+#endif
+
+const lest::test specification[] =
+{
+    CASE( "Allocations are counted with lest_alloc.hpp" )
+    {
+        EXPECT( allocations_counted() );
+    },
+
+    CASE( "Allocation scope counts allocations, bytes and peak of live bytes" )
+    {
+        allocation_scope scope;
+        {
+            std::vector<char> v( 1000 );
+            std::vector<char> w( 500 );
+        }
+        std::vector<char> x( 200 );
+
+        const allocation_counts counts = scope.counts();
+
+        EXPECT( counts.count == 3u );
+        EXPECT( counts.bytes == 1700u );
+        EXPECT( counts.peak  == 1500u );
+    },
+
+    CASE( "Allocation scope counts allocations of other threads" )
+    {
+        allocation_scope scope;
+
+        std::thread( []{ std::vector<char> v( 1000 ); } ).join();
+
+        EXPECT( scope.counts().bytes >= 1000u );
+    },
+
+    CASE( "Expect_no_alloc succeeds for a region without allocations" )
+    {
+        int x = 0;
+        std::vector<int> v( 10 );
+
+        EXPECT_NO_ALLOC( x += 1 );
+        EXPECT_NO_ALLOC( v[ 3 ] = 42 );
+
+        EXPECT( x == 1 );
+    },
+
+    CASE( "Expect_no_alloc fails for a region that allocates" )
+    {
+        test fail[] = {{ CASE( "F" ) { EXPECT_NO_ALLOC( std::vector<int>( 10 ) ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "failed: F: allocations( std::vector<int>( 10 ) ) <= 0 for 1 <= 0" ) );
+    },
+
+    CASE( "Expect_max_allocs succeeds for a region within the limit, fails beyond it" )
+    {
+        test pass[] = {{ CASE( "P" ) { EXPECT_MAX_ALLOCS( 2, std::vector<int>( 10 ) ); } }};
+        test fail[] = {{ CASE( "F" ) { EXPECT_MAX_ALLOCS( 1, std::make_shared<std::vector<int>>( 10 ) ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, os ) );
+        EXPECT( 1 == run( fail, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "failed: F: allocations( std::make_shared<std::vector<int>>( 10 ) ) <= 1 for 2 <= 1" ) );
+    },
+
+    CASE( "Option --pass reports the allocations of a test" "[commandline]" )
+    {
+        test pass[] = {{ CASE( "a" ) { std::vector<char> v( 100 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--pass" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "a: allocations 1, 100 bytes, peak 100 bytes\n" ) );
+    },
+
+    CASE( "Option --time reports the allocations of a test" "[commandline]" )
+    {
+        test pass[] = {{ CASE( "a" ) { std::vector<char> v( 100 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--time" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( " ms: a\n   allocations 1, 100 bytes, peak 100 bytes\n" ) );
+    },
+
+#if lest__heap_profile
+    CASE( "Option --heap-profile reports the top allocating sites of a test and saves folded stacks" "[commandline]" )
+    {
+        test pass[] = {{ CASE( "a" ) { make_block( 100000 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--heap-profile=" + heap_file }, os ) );
+
+        std::ifstream in( heap_file );
+        std::string line;
+        std::getline( in, line );
+        in.close();
+        std::remove( heap_file.c_str() );
+
+        EXPECT( std::string::npos != os.str().find( "a: heap profile, about 1 allocation of 100000 bytes\n" ) );
+        EXPECT( std::string::npos != os.str().find( "  make_block(" ) );
+        EXPECT( std::string::npos == os.str().find( "probable leaks" ) );
+
+        EXPECT( 0u == line.find( "a;" ) );
+        EXPECT( std::string::npos != line.find( "make_block(" ) );
+        EXPECT( line.size() - 7 == line.rfind( " 100000" ) );
+    },
+
+    CASE( "Option --heap-profile doesn't count its own allocations as those of the test" "[commandline]" )
+    {
+        test pass[] = {{ CASE( "a" ) { make_block( 100000 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--heap-profile=" + heap_file, "--time" }, os ) );
+
+        std::remove( heap_file.c_str() );
+
+        EXPECT( std::string::npos != os.str().find( " ms: a\n   allocations 1, 100000 bytes, peak 100000 bytes\n" ) );
+    },
+
+    CASE( "Option --heap-profile reports allocations still live after a test as probable leaks" "[commandline]" )
+    {
+        test pass[] = {{ CASE( "a" ) { leaked = leak_block( 100000 ); } }};
+
+        std::ostringstream os;
+
+        EXPECT( 0 == run( pass, { "--heap-profile=" + heap_file }, os ) );
+
+        delete[] leaked;
+        std::remove( heap_file.c_str() );
+
+        EXPECT( std::string::npos != os.str().find( "a: probable leaks, about 1 allocation of 100000 bytes\n" ) );
+        EXPECT( std::string::npos != os.str().find( "  leak_block(" ) );
+    },
+
+#if lest_FEATURE_JOBS
+    CASE( "Option --heap-profile cannot be combined with option --jobs" "[commandline]" )
+    {
+        test pass[] = {{ CASE( "a" ) { ; } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( pass, { "--heap-profile=" + heap_file, "--jobs=2" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "Error: option --heap-profile cannot be combined with --isolate or --jobs" ) );
+    },
+#endif
+#endif
+
+#if lest_FEATURE_JOBS
+    CASE( "Option --jobs requires option --isolate with allocation accounting" "[commandline]" )
+    {
+        test pass[] = {{ CASE( "a" ) { ; } }};
+
+        std::ostringstream os;
+
+        EXPECT( 1 == run( pass, { "--jobs=2" }, os ) );
+        EXPECT( 0 == run( pass, { "--jobs=1" }, os ) );
+
+        EXPECT( std::string::npos != os.str().find( "Error: option --jobs requires --isolate with lest/lest_alloc.hpp" ) );
+    },
+#endif
+
+#if lest_CPP17_OR_GREATER
+    CASE( "Over-aligned allocations are counted and aligned" )
+    {
+        struct alignas( 256 ) block { char data[ 256 ]; };
+
+        allocation_scope scope;
+        std::unique_ptr<block> p( new block() );
+
+        EXPECT( 0u == reinterpret_cast<std::uintptr_t>( p.get() ) % 256 );
+        EXPECT( scope.counts().bytes == 256u );
+    },
+#endif
+};
+
+int main( int argc, char * argv[] )
+{
+    return lest::run( specification, argc, argv );
+}
+
+// cl -nologo -W3 -EHsc -I../include test_lest_alloc.cpp && test_lest_alloc
+// g++ -Wall -Wextra -std=c++11 -I../include -o test_lest_alloc.exe test_lest_alloc.cpp -pthread && test_lest_alloc
@@ -27,6 +27,14 @@ lest::test_specification no_using_namespace_lest;
 
 struct S { void f(){} };
 
+struct Formatted { int value; static int count; };
+
+int Formatted::count = 0;
+
+bool operator==( Formatted a, Formatted b ) { return a.value == b.value; }
+
+std::ostream & operator<<( std::ostream & os, Formatted f ) { ++Formatted::count; return os << f.value; }
+
 lest_CASE( no_using_namespace_lest, "Namespace lest is specified correctly in lest_cpp03.hpp [compile-only]" )
 {
     EXPECT(  true );
@@ -441,6 +449,35 @@ CASE( "Setup runs as many times as there are sections" )
     EXPECT( i == 2 );
 }
 
+CASE( "Decomposition formats operands only for a failing or reported assertion" )
+{
+    struct f { static void pass(env & lest_env) { Formatted a = { 1 }, b = { 2 }; EXPECT( a == a ); EXPECT_NOT( a == b ); }
+               static void fail(env & lest_env) { Formatted a = { 1 }, b = { 2 }; EXPECT( a == b ); }};
+
+    test pass[] = { test( "P", f::pass ) };
+    test fail[] = { test( "F", f::fail ) };
+
+    std::ostringstream os;
+    char const * args1[] = { "--pass-zen" };
+    char const * args2[] = { "--pass"     };
+
+    Formatted::count = 0;
+
+    EXPECT( 0 == run( pass, os ) );
+    EXPECT( 0 == Formatted::count );
+
+    EXPECT( 0 == run( pass, make_texts( args1 ), os ) );
+    EXPECT( 0 == Formatted::count );
+
+    EXPECT( 0 == run( pass, make_texts( args2 ), os ) );
+    EXPECT( 4 == Formatted::count );
+
+    EXPECT( 1 == run( fail, os ) );
+    EXPECT( 6 == Formatted::count );
+
+    EXPECT( std::string::npos != os.str().find( "a == b for 1 == 2" ) );
+}
+
 #if lest_CPP11_OR_GREATER || lest_COMPILER_MSVC_VERSION
 
 // GNUC -std=c++03: error: ISO C++ forbids comparison between pointer and integer [-fpermissive]